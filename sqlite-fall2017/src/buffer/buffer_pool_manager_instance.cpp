@@ -0,0 +1,1059 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/logger.h"
+namespace cmudb {
+
+static inline uint64_t
+ElapsedNanos(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+static size_t PageClassOf(Page *const &page) {
+  return static_cast<size_t>(page->GetPageClass());
+}
+
+/*
+ * BufferPoolManagerInstance Constructor
+ * When log_manager is nullptr, logging is disabled (for test purpose)
+ * replacer_type chooses the replacement policy (LRU by default)
+ * page_table_type chooses the page table (extendible hashing by default)
+ */
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size,
+                                                     DiskManager *disk_manager,
+                                                     LogManager *log_manager,
+                                                     ReplacerType replacer_type,
+                                                     HashTableType page_table_type)
+    : pool_size_(pool_size), disk_manager_(disk_manager),
+      log_manager_(log_manager), replacer_type_(replacer_type),
+      cleaner_thread_(nullptr), cleaner_running_(false),
+      target_clean_frames_(0), max_writes_per_second_(0),
+      prefetch_thread_(nullptr),
+      prefetch_running_(false), warm_up_thread_(nullptr),
+      warm_up_running_(false), compressed_cache_(nullptr),
+      flash_cache_(nullptr) {
+  // frames are allocated one by one, so the pool can be resized, their
+  // memory comes from the arena in one aligned region
+  if(page_table_type == HashTableType::LINEAR)
+    page_table_ = new LinearHash<page_id_t, Page *>(BUCKET_SIZE);
+  else
+    page_table_ =
+        new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE, MERGE_FILL);
+  free_list_ = new std::list<Page *>;
+  frame_arena_.Reserve(pool_size);
+  // put all the pages into free list
+  for (size_t i = 0; i < pool_size; ++i)
+    free_list_->push_back(CreateFrame());
+  replacer_ = CreateReplacer();
+}
+
+/*
+ * One replacer of replacer_type_ per page class, under a PriorityReplacer
+ */
+Replacer<Page *> *BufferPoolManagerInstance::CreateReplacer() {
+  std::vector<Replacer<Page *> *> replacers;
+  for(int i = 0; i < NUM_PAGE_CLASSES; ++i){
+    if(replacer_type_ == ReplacerType::CLOCK){
+      std::vector<Page *> frames(frames_.begin(), frames_.end());
+      replacers.push_back(new ClockReplacer<Page *>(frames));
+    } else if(replacer_type_ == ReplacerType::LRU_K)
+      // keep the history of as many evicted pages as there are frames
+      replacers.push_back(new LRUKReplacer<Page *>(2, pool_size_));
+    else
+      replacers.push_back(new LRUReplacer<Page *>(next_frame_id_));
+  }
+  return new PriorityReplacer<Page *>(replacers, PageClassOf);
+}
+
+/*
+ * BufferPoolManagerInstance Deconstructor
+ * WARNING: Do Not Edit This Function
+ */
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  StopCleaner();
+  if(warm_up_thread_ != nullptr){
+    warm_up_running_ = false;
+    WaitForWarmUp();
+  }
+  if(prefetch_thread_ != nullptr){
+    {
+      std::lock_guard<std::mutex> lock(prefetch_latch_);
+      prefetch_running_ = false;
+    }
+    prefetch_cv_.notify_all();
+    prefetch_thread_->join();
+    delete prefetch_thread_;
+  }
+  if(!warm_up_file_.empty())
+    DumpResidentPages();
+  for(Page *p : frames_){
+    frame_arena_.Free(p->data_);
+    delete p;
+  }
+  for(Page *p : released_frames_)
+    delete p;
+  delete page_table_;
+  delete replacer_;
+  delete free_list_;
+  delete compressed_cache_;
+  delete flash_cache_;
+}
+
+/**
+ * 1. search hash table.
+ *  1.1 if exist, pin the page and return immediately. If the page is still
+ *      being read by another thread, wait for that read instead of issuing
+ *      a second one
+ *  1.2 if no exist, find a replacement entry from either free list or lru
+ *      replacer. (NOTE: always find from free list first)
+ *      With a bulk read strategy, a frame of the strategy ring is recycled
+ *      before either of them, see GetVictimPage()
+ * 2. If the entry chosen for replacement is dirty, write it back to disk.
+ * 3. Delete the entry for the old page from the hash table and insert an
+ * entry for the new page, marked as I/O in progress.
+ * 4. Update page metadata, read page content from disk file without holding
+ * the latch, then clear the I/O mark and return page pointer
+ */
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id,
+                                   BufferAccessStrategy *strategy,
+                                   PageClass page_class) {
+  //LOG_DEBUG("page_id: %d", page_id);
+  auto start = std::chrono::steady_clock::now();
+  Page* p;
+  bool first;
+  // with CLOCK a hit takes no latch, see UnpinFrame()
+  if(replacer_type_ == ReplacerType::CLOCK && page_table_->Find(page_id, p) &&
+     p->TryPin(first)){
+    if(p->page_id_ == page_id && !p->io_in_progress_){
+      if(first)
+        replacer_->Erase(p);
+      if(page_class > p->GetPageClass())
+        p->SetPageClass(page_class);
+      metrics_.RecordHit(ElapsedNanos(start));
+      return p;
+    }
+    DropPin(p);
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  if(page_table_->Find(page_id, p)){
+    p->pin_count_++;
+    replacer_->Erase(p);
+    // pinned, so out of the replacer: the class may change
+    if(page_class > p->GetPageClass())
+      p->SetPageClass(page_class);
+    // the pin keeps the frame from being reused while waiting
+    WaitForIO(lock, p);
+    metrics_.RecordHit(ElapsedNanos(start));
+    return p;
+  }
+  if((p = GetVictimPage(strategy)) == nullptr)
+    return nullptr;
+  metrics_.RecordFrameWait(ElapsedNanos(start));
+  page_table_->Insert(page_id, p);
+  // Update page metadata, the pin count last: it releases the claim
+  p->page_id_ = page_id;
+  p->io_in_progress_ = true;
+  p->is_dirty_ = false;
+  p->SetPageClass(page_class);
+  p->pin_count_ = 1;
+  // remember the frame in the ring, so the scan recycles it next round
+  if(strategy != nullptr){
+    strategy->ring_[strategy->current_] = p;
+    strategy->ring_page_ids_[strategy->current_] = page_id;
+    strategy->current_ = (strategy->current_ + 1) % strategy->GetRingSize();
+  }
+  lock.unlock();
+  // read page content from disk file, other threads fetching this page wait
+  // in WaitForIO()
+  p->BeginWrite();
+  p->ResetMemory();
+  ReadPage(page_id, p->data_);
+  p->EndWrite();
+  lock.lock();
+  p->io_in_progress_ = false;
+  io_cv_.notify_all();
+  metrics_.RecordMiss(ElapsedNanos(start));
+  return p;
+}
+
+/*
+ * Pin a page found in the page table whose read is complete, as a hit of
+ * FetchPage but without waiting for I/O. Not counted in the metrics, it is
+ * only used to look at pages read ahead
+ */
+Page *BufferPoolManagerInstance::FetchPageIfResident(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  Page *p;
+  if(!page_table_->Find(page_id, p) || p->io_in_progress_)
+    return nullptr;
+  p->pin_count_++;
+  replacer_->Erase(p);
+  return p;
+}
+
+/*
+ * Batch version of FetchPage:
+ * 1. under one acquisition of the latch, pin the pages found in the page
+ * table and install every other page in a victim frame marked as I/O in
+ * progress, as FetchPage does
+ * 2. without the latch, read all the missed pages in one disk manager call,
+ * in page id order
+ * 3. clear the I/O marks, then wait for hits whose read by another thread (or
+ * the prefetcher) is still in flight
+ * A page id given twice is pinned twice.
+ */
+size_t BufferPoolManagerInstance::FetchPages(const page_id_t *page_ids, size_t count,
+                                     Page **pages) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Page *> misses;
+  size_t fetched = 0;
+  std::unique_lock<std::mutex> lock(latch_);
+  for(size_t i = 0; i < count; ++i){
+    Page *p;
+    if(page_table_->Find(page_ids[i], p)){
+      p->pin_count_++;
+      replacer_->Erase(p);
+    } else if((p = GetVictimPage(nullptr)) != nullptr){
+      page_table_->Insert(page_ids[i], p);
+      p->page_id_ = page_ids[i];
+      p->io_in_progress_ = true;
+      p->SetPageClass(PageClass::DATA);
+      p->is_dirty_ = false;
+      p->pin_count_ = 1;
+      misses.push_back(p);
+    }
+    pages[i] = p;
+    if(p != nullptr)
+      fetched++;
+  }
+  metrics_.RecordFrameWait(ElapsedNanos(start));
+  if(!misses.empty()){
+    lock.unlock();
+    std::sort(misses.begin(), misses.end(), [](Page *a, Page *b) {
+      return a->page_id_ < b->page_id_;
+    });
+    ReadPages(misses);
+    lock.lock();
+    for(Page *p : misses)
+      p->io_in_progress_ = false;
+    io_cv_.notify_all();
+  }
+  for(size_t i = 0; i < count; ++i)
+    if(pages[i] != nullptr)
+      WaitForIO(lock, pages[i]);
+  uint64_t elapsed = ElapsedNanos(start);
+  for(size_t i = 0; i < fetched - misses.size(); ++i)
+    metrics_.RecordHit(elapsed);
+  for(size_t i = 0; i < misses.size(); ++i)
+    metrics_.RecordMiss(elapsed);
+  return fetched;
+}
+
+/*
+ * Install page_id in a frame marked as I/O in progress but leave it unpinned,
+ * and hand the read over to the prefetch thread. The frame is chosen here, in
+ * the caller's thread, so a strategy ring is only ever used by its scan.
+ * Nothing happens if the page is resident or no frame can be freed.
+ * A FetchPage of the page before the read completes waits for it, see
+ * WaitForIO(). When the read completes the page becomes evictable.
+ */
+void BufferPoolManagerInstance::Prefetch(page_id_t page_id,
+                                 BufferAccessStrategy *strategy) {
+  if(page_id == INVALID_PAGE_ID)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    Page* p;
+    if(page_table_->Find(page_id, p))
+      return;
+    if((p = GetVictimPage(strategy)) == nullptr)
+      return;
+    page_table_->Insert(page_id, p);
+    p->page_id_ = page_id;
+    p->io_in_progress_ = true;
+    p->SetPageClass(PageClass::DATA);
+    p->is_dirty_ = false;
+    p->pin_count_ = 0;
+    if(strategy != nullptr){
+      strategy->ring_[strategy->current_] = p;
+      strategy->ring_page_ids_[strategy->current_] = page_id;
+      strategy->current_ = (strategy->current_ + 1) % strategy->GetRingSize();
+    }
+    std::lock_guard<std::mutex> prefetch_lock(prefetch_latch_);
+    prefetch_queue_.push_back(p);
+    if(prefetch_thread_ == nullptr){
+      prefetch_running_ = true;
+      prefetch_thread_ =
+          new std::thread(&BufferPoolManagerInstance::RunPrefetcher, this);
+    }
+  }
+  prefetch_cv_.notify_one();
+}
+
+/*
+ * Read the frames queued by Prefetch(). The queue is drained before the
+ * thread exits, so no frame stays marked as I/O in progress
+ */
+void BufferPoolManagerInstance::RunPrefetcher() {
+  std::unique_lock<std::mutex> prefetch_lock(prefetch_latch_);
+  while(true){
+    prefetch_cv_.wait(prefetch_lock, [this] {
+      return !prefetch_queue_.empty() || !prefetch_running_;
+    });
+    if(prefetch_queue_.empty())
+      return;
+    Page *p = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    prefetch_lock.unlock();
+    // nobody else touches the frame until io_in_progress_ is cleared
+    p->BeginWrite();
+    p->ResetMemory();
+    ReadPage(p->page_id_, p->data_);
+    p->EndWrite();
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      p->io_in_progress_ = false;
+      // not fetched while the read was in flight
+      if(p->pin_count_ == 0)
+        replacer_->Insert(p);
+    }
+    io_cv_.notify_all();
+    prefetch_lock.lock();
+  }
+}
+
+/*
+ * Descent step of an index: fetch child_id, read from the pinned page parent.
+ * Pointer swizzling: the frame of a child fetched through parent is kept in
+ * parent's swip slot (child_id % SWIZZLE_SLOTS) while both are resident, so a
+ * later descent pins it directly, skipping the page table. A page id is only
+ * four bytes in the page, so the frame pointers live beside the page data
+ * rather than in place of the child ids; nothing is unswizzled on write back.
+ * A slot is cleared when its frame is evicted or deleted, see Unswizzle().
+ *
+ * A swizzled hit takes no latch: the frame is pinned with Page::TryPin, which
+ * fails on a frame claimed for reuse, then checked. The slot may have been
+ * read just before the frame was evicted and reused (a pinned frame can not
+ * be claimed, so this is settled once the pin is taken), slots collide, and a
+ * child may have moved to another parent since it was swizzled. If the frame
+ * does not hold child_id, loaded, the pin is dropped and the page is fetched
+ * through the page table.
+ * The first pin of a frame takes it out of the replacer (every replacer has
+ * its own lock), so a pinned frame is not peeked or victimized, and its class
+ * can be raised (see BPlusTree::ChildPage) while the replacer does not hold
+ * it. An unpin racing with the pin may still put the frame back for a
+ * moment, GetVictimPage(), the cleaner and DumpResidentPages() skip pinned
+ * frames.
+ */
+Page *BufferPoolManagerInstance::FetchChild(Page *parent, page_id_t child_id) {
+  auto start = std::chrono::steady_clock::now();
+  std::atomic<Page *> *swips = parent->swips_.load(std::memory_order_acquire);
+  if(swips != nullptr){
+    Page *p = swips[child_id % SWIZZLE_SLOTS].load(std::memory_order_acquire);
+    bool first;
+    if(p != nullptr && p->TryPin(first)){
+      if(p->page_id_ == child_id && !p->io_in_progress_){
+        if(first)
+          replacer_->Erase(p);
+        metrics_.RecordHit(ElapsedNanos(start));
+        return p;
+      }
+      DropPin(p);
+    }
+  }
+  Page *p = FetchPage(child_id);
+  if(p == nullptr)
+    return nullptr;
+  std::lock_guard<std::mutex> lock(latch_);
+  Swizzle(parent, p);
+  return p;
+}
+
+/*
+ * Undo a TryPin of FetchChild on a frame that turned out to hold another page.
+ * While pinned, the frame keeps its page. A frame of no page is on the free
+ * list, GetVictimPage() waits for the pin to go, so no latch is needed. A
+ * frame of a page may have been taken off the replacer meanwhile, the last
+ * pin puts it back as UnpinPage does
+ */
+void BufferPoolManagerInstance::DropPin(Page *page) {
+  if(page->page_id_ == INVALID_PAGE_ID){
+    page->pin_count_--;
+    return;
+  }
+  std::lock_guard<std::mutex> lock(latch_);
+  if(--page->pin_count_ == 0 && !page->io_in_progress_)
+    replacer_->Insert(page);
+}
+
+/*
+ * Put child in its swip slot of parent, both pinned. The frame the slot held
+ * before and the slot child was in before are unlinked, so a frame is
+ * referenced by at most one slot and knows which one
+ */
+void BufferPoolManagerInstance::Swizzle(Page *parent, Page *child) {
+  // allocated once, slot addresses stay valid as long as the frame
+  std::atomic<Page *> *swips = parent->swips_.load();
+  if(swips == nullptr){
+    swips = new std::atomic<Page *>[SWIZZLE_SLOTS];
+    for(int i = 0; i < SWIZZLE_SLOTS; ++i)
+      swips[i] = nullptr;
+    parent->swips_.store(swips, std::memory_order_release);
+  }
+  std::atomic<Page *> &slot = swips[child->page_id_ % SWIZZLE_SLOTS];
+  Page *old_child = slot;
+  if(old_child == child)
+    return;
+  if(old_child != nullptr)
+    old_child->swip_ref_ = nullptr;
+  if(child->swip_ref_ != nullptr)
+    *child->swip_ref_ = nullptr;
+  slot = child;
+  child->swip_ref_ = &slot;
+}
+
+/*
+ * page leaves its frame: clear the slot pointing at it, and the slots of the
+ * page itself, whose frames then no longer point back into it
+ */
+void BufferPoolManagerInstance::Unswizzle(Page *page) {
+  if(page->swip_ref_ != nullptr){
+    *page->swip_ref_ = nullptr;
+    page->swip_ref_ = nullptr;
+  }
+  std::atomic<Page *> *swips = page->swips_.load();
+  if(swips == nullptr)
+    return;
+  for(int i = 0; i < SWIZZLE_SLOTS; ++i){
+    Page *child = swips[i];
+    if(child != nullptr){
+      child->swip_ref_ = nullptr;
+      swips[i] = nullptr;
+    }
+  }
+}
+
+/*
+ * Implementation of unpin page
+ * if pin_count>0, decrement it and if it becomes zero, put it back to
+ * replacer if pin_count<=0 before this call, return false. is_dirty: set the
+ * dirty flag of this page
+ */
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  Page* p;
+  if(replacer_type_ == ReplacerType::CLOCK){
+    // the caller's pin keeps the page in its frame
+    if(!page_table_->Find(page_id, p) || p->page_id_ != page_id)
+      return false;
+    return UnpinFrame(p, is_dirty);
+  }
+  std::lock_guard<std::mutex> lock(latch_);
+  //LOG_DEBUG("page_id: %d", page_id);
+  if(!(page_table_->Find(page_id, p))){
+    //LOG_DEBUG("can't find the page");
+    return false;
+  }
+  if(is_dirty)
+    p->is_dirty_ = true;
+  if(p->pin_count_ > 0){
+    if(--p->pin_count_ == 0)
+      replacer_->Insert(p);
+    return true;
+  }else{
+    //LOG_DEBUG("pin_count below zero: %d", p->pin_count_);
+    return false;
+  }  
+}
+
+/*
+ * Same as above for a frame the caller has pinned: the frame is at hand, so
+ * there is no page table lookup
+ */
+bool BufferPoolManagerInstance::UnpinPage(Page *page, bool is_dirty) {
+  if(replacer_type_ == ReplacerType::CLOCK)
+    return UnpinFrame(page, is_dirty);
+  std::lock_guard<std::mutex> lock(latch_);
+  assert(frames_.count(page) == 1);
+  if(is_dirty)
+    page->is_dirty_ = true;
+  if(page->pin_count_ <= 0)
+    return false;
+  if(--page->pin_count_ == 0)
+    replacer_->Insert(page);
+  return true;
+}
+
+/*
+ * Unpin without the latch, for the CLOCK replacer, whose Insert and Erase
+ * only flip flags of the frame's slot. The hit path of FetchPage pins the
+ * same way, with Page::TryPin, which fails on a frame claimed for reuse, so
+ * pin and unpin of resident pages do not serialize on latch_.
+ * A frame may be pinned again between its last unpin and the Insert here, it
+ * is then in the replacer while pinned: GetVictimPage() fails to claim it and
+ * drops it, and its next last unpin puts it back. The dirty flag is set before
+ * the pin goes, a claim of the frame sees it
+ */
+bool BufferPoolManagerInstance::UnpinFrame(Page *page, bool is_dirty) {
+  if(is_dirty)
+    page->is_dirty_ = true;
+  int pin_count = page->Unpin();
+  if(pin_count < 0)
+    return false;
+  if(pin_count == 0)
+    replacer_->Insert(page);
+  return true;
+}
+
+/*
+ * Used to flush a particular page of the buffer pool to disk. Should call the
+ * write_page method of the disk manager
+ * if page is not found in page table, return false
+ * NOTE: make sure page_id != INVALID_PAGE_ID
+ */
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) { 
+  std::lock_guard<std::mutex> lock(latch_);
+  Page* p;
+  if(page_id == INVALID_PAGE_ID || !(page_table_->Find(page_id, p)))
+    return false;
+  // still being read from disk, the disk copy is up to date
+  if(p->io_in_progress_)
+    return true;
+  WritePage(p);
+  return true; 
+}
+
+size_t BufferPoolManagerInstance::FlushAllPages() {
+  return FlushPages(0, std::numeric_limits<page_id_t>::max());
+}
+
+/*
+ * Collect the dirty pages of the range and mark them clean, so a page changed
+ * while it is written is unpinned dirty again. Flush the log up to the
+ * largest page LSN, then hand the pages sorted by id to the disk manager,
+ * which writes runs of consecutive pages at once. Like FlushPage() and
+ * write-back on eviction this holds latch_ throughout: pinning the pages
+ * instead would reorder the replacer as if they had all been used
+ */
+size_t BufferPoolManagerInstance::FlushPages(page_id_t first_page_id,
+                                     page_id_t last_page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  std::vector<Page *> pages;
+  lsn_t max_lsn = INVALID_LSN;
+  for(Page *p : frames_){
+    if(p->page_id_ == INVALID_PAGE_ID || p->page_id_ < first_page_id ||
+       p->page_id_ > last_page_id || !p->is_dirty_ || p->io_in_progress_)
+      continue;
+    p->is_dirty_ = false;
+    max_lsn = std::max(max_lsn, p->GetLSN());
+    pages.push_back(p);
+  }
+  if(pages.empty())
+    return 0;
+  if(ENABLE_LOGGING && log_manager_ != nullptr &&
+     max_lsn > log_manager_->GetPersistentLSN()){
+    log_manager_->WakeUpFlushThread();
+    log_manager_->WaitFlush();
+  }
+  std::sort(pages.begin(), pages.end(), [](Page *a, Page *b) {
+    return a->page_id_ < b->page_id_;
+  });
+  std::vector<page_id_t> page_ids;
+  std::vector<const char *> page_data;
+  for(Page *p : pages){
+    // as in WritePage()
+    if(flash_cache_ != nullptr)
+      flash_cache_->Erase(p->page_id_);
+    page_ids.push_back(p->page_id_);
+    page_data.push_back(p->data_);
+  }
+  disk_manager_->WritePages(page_ids.data(), page_data.data(), pages.size());
+  return pages.size();
+}
+
+/**
+ * User should call this method for deleting a page. This routine will call
+ * disk manager to deallocate the page. First, if page is found within page
+ * table, buffer pool manager should be reponsible for removing this entry out
+ * of page table, reseting page metadata and adding back to free list. Second,
+ * call disk manager's DeallocatePage() method to delete from disk file. If
+ * the page is found within page table, but pin_count != 0, return false
+ */
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  Page* p;
+  if(compressed_cache_ != nullptr)
+    compressed_cache_->Erase(page_id);
+  if(flash_cache_ != nullptr)
+    flash_cache_->Erase(page_id);
+  //LOG_DEBUG("page_id: %d", page_id);
+  if(!(page_table_->Find(page_id, p)))
+    return false;
+  // being read by the prefetch thread
+  if(p->io_in_progress_)
+    return false;
+  // pinned, maybe by FetchChild without the latch
+  if(!p->TryClaim()){
+    std::cout << "pin_count_ :" << p->pin_count_ << std::endl; 
+    return false;
+  }
+  replacer_->Erase(p);
+  page_table_->Remove(p->page_id_);
+  Unswizzle(p);
+  // Update page metadata
+  p->BeginWrite();
+  p->ResetMemory();
+  p->EndWrite();
+  disk_manager_->DeallocatePage(page_id);
+  p->page_id_ = INVALID_PAGE_ID;
+  p->is_dirty_ = false;
+  p->SetPageClass(PageClass::DATA);
+  p->pin_count_ = 0;
+  free_list_->push_back(p);
+  return true; 
+}
+
+/**
+ * User should call this method if needs to create a new page. This routine
+ * will call disk manager to allocate a page.
+ * Buffer pool manager should be responsible to choose a victim page either
+ * from free list or lru replacer(NOTE: always choose from free list first),
+ * update new page's metadata, zero out memory and add corresponding entry
+ * into page table. return nullptr if all the pages in pool are pinned
+ */
+Page *BufferPoolManagerInstance::NewPage(page_id_t &page_id,
+                                         PageClass page_class) {
+  return CreatePage(page_id, page_class, true);
+}
+
+/*
+ * NewPage, allocating the page id from disk manager once a frame is found if
+ * allocate_id is set. Otherwise page_id is an id the caller got from disk
+ * manager, it is left unused if all the pages in pool are pinned
+ */
+Page *BufferPoolManagerInstance::CreatePage(page_id_t &page_id,
+                                            PageClass page_class,
+                                            bool allocate_id) {
+  auto start = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(latch_);
+  Page* p;
+  if((p = GetVictimPage(nullptr)) == nullptr)
+    return nullptr;
+  metrics_.RecordFrameWait(ElapsedNanos(start));
+  if(allocate_id)
+    page_id = disk_manager_->AllocatePage();
+  page_table_->Insert(page_id, p);
+  // Update page metadata
+  p->BeginWrite();
+  p->ResetMemory();
+  p->EndWrite();
+  p->page_id_ = page_id;
+  p->is_dirty_ = false;
+  p->SetPageClass(page_class);
+  p->pin_count_ = 1;
+  //LOG_DEBUG("page_id: %d", page_id);
+  return p;
+}
+
+/*
+ * Find a frame for a page that is not in the buffer pool. If strategy is given
+ * and the frame at its ring position still holds the page the ring loaded and
+ * is unpinned, recycle it. Otherwise take one from free list, then from lru
+ * replacer. The old page of the frame is written back if dirty (write ahead
+ * log first) and removed from the page table.
+ * The frame is returned claimed (see Page::TryClaim), the caller sets its pin
+ * count. A victim of the replacer pinned by FetchChild since it was unpinned
+ * is skipped, it goes back to the replacer with its last unpin.
+ * return nullptr if all the pages in pool are pinned
+ */
+Page *BufferPoolManagerInstance::GetVictimPage(BufferAccessStrategy *strategy) {
+  Page* p = nullptr;
+  Page *ring_page = nullptr;
+  if(strategy != nullptr){
+    ring_page = strategy->ring_[strategy->current_];
+    // the ring may hold frames of other instances of a parallel pool, or
+    // frames released by Resize()
+    if(frames_.count(ring_page) == 1 &&
+       ring_page->page_id_ == strategy->ring_page_ids_[strategy->current_] &&
+       ring_page->pin_count_ == 0 && replacer_->Erase(ring_page) &&
+       ring_page->TryClaim())
+      p = ring_page;
+  }
+  while(p == nullptr){
+    if(!free_list_->empty()){
+      p = TakeFreeFrame();
+      break;
+    }
+    if(!(replacer_->Victim(p)))
+      return nullptr;
+    // a frame may be left in the replacer under a page class it had before,
+    // after it was freed or pinned and reclassified
+    if(frames_.count(p) == 0 || p->page_id_ == INVALID_PAGE_ID ||
+       !p->TryClaim())
+      p = nullptr;
+  }
+  if(p->page_id_ == INVALID_PAGE_ID)
+    return p;
+  metrics_.RecordEviction();
+  page_table_->Remove(p->page_id_);
+  Unswizzle(p);
+  // deal with dirty page: write ahead log, flush page.
+  if(p->is_dirty_){
+    if(ENABLE_LOGGING && p->GetLSN() > log_manager_->GetPersistentLSN()){
+      log_manager_->WakeUpFlushThread();
+      log_manager_->WaitFlush();
+    }
+    WritePage(p);
+    metrics_.RecordForegroundWrite();
+  }
+  // the disk copy is up to date now. Pages of a bulk read ring are not kept,
+  // they would push out the pages evicted by the regular workload. Both
+  // caches only copy the page here, compression and the cache file write
+  // happen later in their own threads
+  if(p != ring_page){
+    if(compressed_cache_ != nullptr)
+      compressed_cache_->Stage(p->page_id_, p->data_);
+    if(flash_cache_ != nullptr)
+      flash_cache_->Stage(p->page_id_, p->data_);
+  }
+  return p;
+}
+
+/*
+ * Claim the first frame of the free list. It holds no page, a pin on it can
+ * only be one of FetchChild through a stale slot, which lets go right away
+ */
+Page *BufferPoolManagerInstance::TakeFreeFrame() {
+  Page *p = free_list_->front();
+  free_list_->pop_front();
+  while(!p->TryClaim())
+    std::this_thread::yield();
+  return p;
+}
+
+/*
+ * Make a frame over arena memory and number it, see Page::GetFrameId()
+ */
+Page *BufferPoolManagerInstance::CreateFrame() {
+  Page *p = new Page(frame_arena_.Allocate());
+  p->frame_id_ = next_frame_id_++;
+  frames_.insert(p);
+  return p;
+}
+
+/*
+ * Grow or shrink the pool to new_size frames while it is in use.
+ * Growing allocates new frames onto the free list. Shrinking releases free
+ * frames first, then evicts pages through GetVictimPage() (dirty ones are
+ * written back) and releases their memory. The Page of a released frame
+ * stays claimed until the pool is destroyed, FetchChild may still find it in
+ * a stale slot. Pinned frames and frames with a
+ * read in flight are kept, so a shrink may stop above new_size.
+ * The replacer is kept, a new frame gets its place in it on its first unpin.
+ * @return: the pool size afterwards
+ */
+size_t BufferPoolManagerInstance::Resize(size_t new_size) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if(frames_.size() < new_size)
+    frame_arena_.Reserve(new_size - frames_.size());
+  while(frames_.size() < new_size)
+    free_list_->push_back(CreateFrame());
+  while(frames_.size() > new_size){
+    Page *p = GetVictimPage(nullptr);
+    if(p == nullptr)
+      break;
+    frames_.erase(p);
+    frame_arena_.Free(p->data_);
+    released_frames_.push_back(p);
+  }
+  pool_size_ = frames_.size();
+  return pool_size_;
+}
+
+size_t BufferPoolManagerInstance::GetFrameMemory() {
+  std::lock_guard<std::mutex> lock(latch_);
+  return frame_arena_.GetMappedBytes();
+}
+
+BufferPoolMetricsSnapshot BufferPoolManagerInstance::GetMetrics() {
+  BufferPoolMetricsSnapshot snapshot = metrics_.Snapshot();
+  std::lock_guard<std::mutex> lock(latch_);
+  for(Page *p : frames_)
+    if(p->page_id_ != INVALID_PAGE_ID)
+      snapshot.resident_pages[PageClassOf(p)]++;
+  return snapshot;
+}
+
+/*
+ * The page is resident: the compressed cache does not hold it, and no read
+ * of it can reach the flash cache meanwhile. Its flash copy is dropped
+ * before the page changes on disk, eviction writes it again
+ */
+void BufferPoolManagerInstance::WritePage(Page *page) {
+  if(flash_cache_ != nullptr)
+    flash_cache_->Erase(page->page_id_);
+  disk_manager_->WritePage(page->page_id_, page->data_);
+}
+
+/*
+ * Read page_id for a frame marked as I/O in progress: from the compressed
+ * cache, then the flash cache, from disk if neither holds the page
+ */
+void BufferPoolManagerInstance::ReadPage(page_id_t page_id, char *data) {
+  if(compressed_cache_ != nullptr && compressed_cache_->Lookup(page_id, data))
+    return;
+  if(flash_cache_ != nullptr && flash_cache_->Lookup(page_id, data))
+    return;
+  disk_manager_->ReadPage(page_id, data);
+}
+
+/*
+ * Batch version of ReadPage for frames sorted by page id: the pages not in
+ * the compressed cache are read in one disk manager call
+ */
+void BufferPoolManagerInstance::ReadPages(const std::vector<Page *> &pages) {
+  std::vector<page_id_t> page_ids;
+  std::vector<char *> page_data;
+  for(Page *p : pages){
+    p->BeginWrite();
+    p->ResetMemory();
+    if(compressed_cache_ != nullptr &&
+       compressed_cache_->Lookup(p->page_id_, p->data_))
+      continue;
+    if(flash_cache_ != nullptr && flash_cache_->Lookup(p->page_id_, p->data_))
+      continue;
+    page_ids.push_back(p->page_id_);
+    page_data.push_back(p->data_);
+  }
+  if(!page_ids.empty())
+    disk_manager_->ReadPages(page_ids.data(), page_data.data(),
+                             page_ids.size());
+  for(Page *p : pages)
+    p->EndWrite();
+}
+
+void BufferPoolManagerInstance::EnableCompressedCache(size_t budget) {
+  assert(compressed_cache_ == nullptr);
+  compressed_cache_ = new CompressedPageCache(budget);
+}
+
+void BufferPoolManagerInstance::EnableFlashCache(const std::string &file_name,
+                                         size_t num_slots) {
+  assert(flash_cache_ == nullptr);
+  flash_cache_ = new FlashCache(file_name, num_slots);
+}
+
+/*
+ * Block until the disk read of page (started by FetchPage of another thread)
+ * completes. latch_ is released while waiting
+ */
+void BufferPoolManagerInstance::WaitForIO(std::unique_lock<std::mutex> &lock,
+                                  Page *page) {
+  io_cv_.wait(lock, [page] { return !page->io_in_progress_; });
+}
+
+/*
+ * Start the page cleaner thread, see RunCleaner()
+ */
+void BufferPoolManagerInstance::StartCleaner(size_t target_clean_frames,
+                                     size_t max_writes_per_second) {
+  assert(cleaner_thread_ == nullptr);
+  target_clean_frames_ = target_clean_frames;
+  max_writes_per_second_ = max_writes_per_second;
+  cleaner_running_ = true;
+  cleaner_thread_ = new std::thread(&BufferPoolManagerInstance::RunCleaner, this);
+}
+
+/*
+ * Stop and join the page cleaner thread, if it is running
+ */
+void BufferPoolManagerInstance::StopCleaner() {
+  if(cleaner_thread_ == nullptr)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(cleaner_latch_);
+    cleaner_running_ = false;
+  }
+  cleaner_cv_.notify_all();
+  cleaner_thread_->join();
+  delete cleaner_thread_;
+  cleaner_thread_ = nullptr;
+}
+
+/*
+ * Every CLEANER_INTERVAL milliseconds, walk the cold end of the replacer
+ * (the next victims) and write back dirty unpinned pages until
+ * target_clean_frames_ frames (free list included) are clean, or the write
+ * budget of this round is used up. A page whose LSN is not persistent yet is
+ * skipped, it is taken again in a later round once the log flush thread has
+ * caught up. latch_ is taken per page, so a foreground fetch waits for at
+ * most one page write
+ */
+void BufferPoolManagerInstance::RunCleaner() {
+  const auto interval = std::chrono::milliseconds(CLEANER_INTERVAL);
+  size_t budget_per_round =
+      std::max<size_t>(1, max_writes_per_second_ * CLEANER_INTERVAL / 1000);
+  std::unique_lock<std::mutex> cleaner_lock(cleaner_latch_);
+  while(!cleaner_cv_.wait_for(cleaner_lock, interval,
+                              [this] { return !cleaner_running_; })){
+    std::vector<Page *> candidates;
+    size_t clean;
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      clean = free_list_->size();
+      if(clean < target_clean_frames_)
+        replacer_->PeekVictims(target_clean_frames_ - clean, candidates);
+    }
+    size_t budget = budget_per_round;
+    for(Page *p : candidates){
+      if(budget == 0)
+        break;
+      std::lock_guard<std::mutex> lock(latch_);
+      // the page may have been pinned or evicted since PeekVictims, or its
+      // frame released by Resize()
+      if(frames_.count(p) == 0 || p->pin_count_ > 0 || p->io_in_progress_ ||
+         p->page_id_ == INVALID_PAGE_ID || !p->is_dirty_)
+        continue;
+      if(ENABLE_LOGGING && log_manager_ != nullptr &&
+         p->GetLSN() > log_manager_->GetPersistentLSN())
+        continue;
+      // no FetchChild pins the page while it is written
+      if(!p->TryClaim())
+        continue;
+      WritePage(p);
+      p->is_dirty_ = false;
+      p->pin_count_ = 0;
+      metrics_.RecordBackgroundWrite();
+      budget--;
+    }
+  }
+}
+
+void BufferPoolManagerInstance::ShowPinCount(page_id_t page_id){
+  Page* p;
+  //LOG_DEBUG("page_id: %d", page_id);
+  if(!(page_table_->Find(page_id, p))){
+    //LOG_DEBUG("can't find the page");
+    return;
+  }
+  //LOG_DEBUG("pin_count: %d", p->pin_count_);
+};
+
+/*
+ * Turn warm-up on. If file_name holds the page ids of a previous run, start
+ * loading them in the background; requests are served meanwhile. Call it
+ * once, before the pool is used much: warm-up only fills free frames
+ */
+void BufferPoolManagerInstance::EnableWarmUp(const std::string &file_name) {
+  warm_up_file_ = file_name;
+  std::vector<page_id_t> page_ids;
+  std::ifstream input(file_name);
+  page_id_t page_id;
+  while(input >> page_id)
+    page_ids.push_back(page_id);
+  if(page_ids.empty())
+    return;
+  warm_up_running_ = true;
+  warm_up_thread_ =
+      new std::thread(&BufferPoolManagerInstance::RunWarmUp, this, std::move(page_ids));
+}
+
+void BufferPoolManagerInstance::WaitForWarmUp() {
+  if(warm_up_thread_ == nullptr)
+    return;
+  warm_up_thread_->join();
+  delete warm_up_thread_;
+  warm_up_thread_ = nullptr;
+}
+
+/*
+ * Write the ids of the resident pages to the warm-up file, one per line,
+ * hottest first: pinned pages, then the replacer from its most recently
+ * used end. The file is replaced atomically, a crash leaves the old one
+ */
+bool BufferPoolManagerInstance::DumpResidentPages() {
+  if(warm_up_file_.empty())
+    return false;
+  std::vector<page_id_t> page_ids;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    for(Page *p : frames_)
+      if(p->pin_count_ > 0 && p->page_id_ != INVALID_PAGE_ID)
+        page_ids.push_back(p->page_id_);
+    std::vector<Page *> victims;
+    replacer_->PeekVictims(pool_size_, victims);
+    // a frame pinned without the latch may be in the replacer a while
+    for(auto it = victims.rbegin(); it != victims.rend(); ++it)
+      if((*it)->pin_count_ == 0 && (*it)->page_id_ != INVALID_PAGE_ID)
+        page_ids.push_back((*it)->page_id_);
+  }
+  std::string temp_file = warm_up_file_ + ".tmp";
+  {
+    std::ofstream output(temp_file, std::ios::trunc);
+    for(page_id_t page_id : page_ids)
+      output << page_id << '\n';
+    if(!output.good())
+      return false;
+  }
+  return std::rename(temp_file.c_str(), warm_up_file_.c_str()) == 0;
+}
+
+/*
+ * Load the pages of the previous run, at most a pool of them, hottest first
+ * in the file. They are read in page id order, WARM_UP_BATCH_SIZE pages per
+ * disk manager call, into free frames only, so pages the running workload
+ * has brought in are never evicted for them. Like prefetched pages, a frame
+ * is marked as I/O in progress while its read is in flight and is evictable
+ * once loaded.
+ */
+void BufferPoolManagerInstance::RunWarmUp(std::vector<page_id_t> page_ids) {
+  if(page_ids.size() > pool_size_)
+    page_ids.resize(pool_size_);
+  std::sort(page_ids.begin(), page_ids.end());
+  bool pool_full = false;
+  for(size_t begin = 0; begin < page_ids.size() && !pool_full &&
+                        warm_up_running_; begin += WARM_UP_BATCH_SIZE){
+    size_t end = std::min(begin + WARM_UP_BATCH_SIZE, page_ids.size());
+    std::vector<Page *> frames;
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      for(size_t i = begin; i < end; ++i){
+        Page *p;
+        if(page_ids[i] < 0 || page_table_->Find(page_ids[i], p))
+          continue;
+        if(free_list_->empty()){
+          pool_full = true;
+          break;
+        }
+        p = TakeFreeFrame();
+        page_table_->Insert(page_ids[i], p);
+        p->page_id_ = page_ids[i];
+        p->io_in_progress_ = true;
+        p->SetPageClass(PageClass::DATA);
+        p->is_dirty_ = false;
+        p->pin_count_ = 0;
+        frames.push_back(p);
+      }
+    }
+    if(frames.empty())
+      continue;
+    ReadPages(frames);
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      for(Page *p : frames){
+        p->io_in_progress_ = false;
+        if(p->pin_count_ == 0)
+          replacer_->Insert(p);
+      }
+    }
+    io_cv_.notify_all();
+  }
+}
+
+} // namespace cmudb
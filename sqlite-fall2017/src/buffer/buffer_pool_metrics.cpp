@@ -0,0 +1,61 @@
+/**
+ * buffer_pool_metrics.cpp
+ */
+#include "buffer/buffer_pool_metrics.h"
+
+namespace cmudb {
+
+BufferPoolMetricsSnapshot &BufferPoolMetricsSnapshot::
+operator+=(const BufferPoolMetricsSnapshot &rhs) {
+  hits += rhs.hits;
+  misses += rhs.misses;
+  evictions += rhs.evictions;
+  foreground_writes += rhs.foreground_writes;
+  background_writes += rhs.background_writes;
+  frame_wait_ns += rhs.frame_wait_ns;
+  for (int i = 0; i < METRICS_LATENCY_BUCKETS; ++i) {
+    hit_latency[i] += rhs.hit_latency[i];
+    miss_latency[i] += rhs.miss_latency[i];
+  }
+  for (int i = 0; i < NUM_PAGE_CLASSES; ++i)
+    resident_pages[i] += rhs.resident_pages[i];
+  return *this;
+}
+
+/*
+ * Every thread gets a shard index the first time it records anything, round
+ * robin over METRICS_SHARDS. The index is shared by all the pools
+ */
+BufferPoolMetrics::Shard &BufferPoolMetrics::LocalShard() {
+  static std::atomic<unsigned> next_shard(0);
+  thread_local unsigned shard = next_shard++ % METRICS_SHARDS;
+  return shards_[shard];
+}
+
+/*
+ * Add up all the shards. Counters keep moving while this runs, so the
+ * snapshot is not a single point in time
+ */
+BufferPoolMetricsSnapshot BufferPoolMetrics::Snapshot() const {
+  BufferPoolMetricsSnapshot snapshot;
+  for (const Shard &shard : shards_) {
+    snapshot.hits += shard.hits.load(std::memory_order_relaxed);
+    snapshot.misses += shard.misses.load(std::memory_order_relaxed);
+    snapshot.evictions += shard.evictions.load(std::memory_order_relaxed);
+    snapshot.foreground_writes +=
+        shard.foreground_writes.load(std::memory_order_relaxed);
+    snapshot.background_writes +=
+        shard.background_writes.load(std::memory_order_relaxed);
+    snapshot.frame_wait_ns +=
+        shard.frame_wait_ns.load(std::memory_order_relaxed);
+    for (int i = 0; i < METRICS_LATENCY_BUCKETS; ++i) {
+      snapshot.hit_latency[i] +=
+          shard.hit_latency[i].load(std::memory_order_relaxed);
+      snapshot.miss_latency[i] +=
+          shard.miss_latency[i].load(std::memory_order_relaxed);
+    }
+  }
+  return snapshot;
+}
+
+} // namespace cmudb
@@ -0,0 +1,142 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+ClockReplacer<T>::ClockReplacer(const std::vector<T> &frames)
+    : num_slots_(0), size_(0), hand_(0) {
+  for (size_t i = 0; i < MAX_SEGMENTS; ++i)
+    segments_[i] = nullptr;
+  for (const T &value : frames)
+    AddSlot(FrameOf(value), value);
+}
+
+template <typename T> ClockReplacer<T>::~ClockReplacer() {
+  for (size_t i = 0; i < MAX_SEGMENTS; ++i)
+    delete[] segments_[i].load();
+}
+
+/*
+ * Segment i starts at frame FIRST_SEGMENT * (2^i - 1). Lock free
+ */
+template <typename T>
+typename ClockReplacer<T>::Slot *ClockReplacer<T>::GetSlot(size_t frame) {
+  size_t segment = 63 - __builtin_clzll(frame / FIRST_SEGMENT + 1);
+  assert(segment < MAX_SEGMENTS);
+  Slot *slots = segments_[segment].load(std::memory_order_acquire);
+  if(slots == nullptr)
+    return nullptr;
+  return slots + (frame - FIRST_SEGMENT * ((size_t(1) << segment) - 1));
+}
+
+/*
+ * Allocate the segments up to the one of frame, under victim_latch_ so the
+ * sweep sees whole segments, and set the value of its slot once
+ */
+template <typename T>
+typename ClockReplacer<T>::Slot *ClockReplacer<T>::AddSlot(size_t frame,
+                                                           const T &value) {
+  std::lock_guard<std::mutex> guard(victim_latch_);
+  Slot *slot;
+  while((slot = GetSlot(frame)) == nullptr){
+    size_t segment = 0;
+    while(segments_[segment].load() != nullptr)
+      segment++;
+    segments_[segment].store(new Slot[FIRST_SEGMENT << segment],
+                             std::memory_order_release);
+    num_slots_ = FIRST_SEGMENT * ((size_t(2) << segment) - 1);
+  }
+  if(!slot->known.load()){
+    slot->value = value;
+    slot->known.store(true, std::memory_order_release);
+  }
+  return slot;
+}
+
+/*
+ * Mark value as evictable and give it a second chance. Lock free, except the
+ * first Insert of a frame
+ */
+template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+  Slot *slot = GetSlot(FrameOf(value));
+  if(slot == nullptr || !slot->known.load(std::memory_order_acquire))
+    slot = AddSlot(FrameOf(value), value);
+  // set the reference bit first so a concurrent sweep can not take it
+  // before it got its second chance
+  slot->ref.store(true);
+  if(!slot->evictable.exchange(true))
+    size_++;
+}
+
+/*
+ * Sweep the clock hand: clear reference bits until an evictable slot without
+ * reference bit is found. Return false if nothing is evictable.
+ */
+template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(victim_latch_);
+  while(size_.load() > 0){
+    Slot &slot = *GetSlot(hand_);
+    hand_ = (hand_ + 1) % num_slots_;
+    if(!slot.evictable.load())
+      continue;
+    if(slot.ref.exchange(false))
+      continue;
+    // may race with Erase (pin) of the same value, whoever flips it wins
+    bool expected = true;
+    if(slot.evictable.compare_exchange_strong(expected, false)){
+      size_--;
+      value = slot.value;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Remove value from replacer (value is pinned). Lock free.
+ * return true if value was evictable before this call
+ */
+template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+  Slot *slot = GetSlot(FrameOf(value));
+  if(slot == nullptr)
+    return false;
+  if(slot->evictable.exchange(false)){
+    size_--;
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Append up to n evictable values in the order the clock hand reaches them.
+ * Reference bits are not cleared, so this only approximates the victim order
+ */
+template <typename T>
+void ClockReplacer<T>::PeekVictims(size_t n, std::vector<T> &values) {
+  std::lock_guard<std::mutex> guard(victim_latch_);
+  size_t num_slots = num_slots_;
+  for(size_t i = 0; i < num_slots && n > 0; ++i){
+    Slot &slot = *GetSlot((hand_ + i) % num_slots);
+    if(slot.evictable.load()){
+      values.push_back(slot.value);
+      n--;
+    }
+  }
+}
+
+template <typename T> size_t ClockReplacer<T>::Size() { return size_.load(); }
+
+template <typename T> const size_t ClockReplacer<T>::FIRST_SEGMENT;
+template <typename T> const size_t ClockReplacer<T>::MAX_SEGMENTS;
+
+template class ClockReplacer<Page *>;
+// test only
+template class ClockReplacer<int>;
+
+} // namespace cmudb
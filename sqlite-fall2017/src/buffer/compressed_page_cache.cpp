@@ -0,0 +1,267 @@
+/**
+ * compressed_page_cache.cpp
+ */
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "buffer/compressed_page_cache.h"
+
+namespace cmudb {
+
+/*
+ * Codec format, a sequence of tokens:
+ * - control byte c < 128: a literal run, the next c + 1 bytes are copied
+ * - control byte c >= 128: a match of (c - 128) + LZ_MIN_MATCH bytes, copied
+ *   from offset bytes back in the output, offset in the next 2 bytes (little
+ *   endian). The match may overlap its own output, so a run of one byte is a
+ *   match at offset 1.
+ */
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_MATCH (127 + LZ_MIN_MATCH)
+#define LZ_MAX_LITERALS 128
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12
+
+static inline void AppendLiterals(const char *src, size_t count,
+                                  std::string &dst) {
+  while(count > 0){
+    size_t run = std::min<size_t>(count, LZ_MAX_LITERALS);
+    dst.push_back(static_cast<char>(run - 1));
+    dst.append(src, run);
+    src += run;
+    count -= run;
+  }
+}
+
+/*
+ * Greedy LZ77: the last position of every 4 byte sequence is kept in a small
+ * hash table, a candidate that really matches is extended as far as it goes
+ */
+bool CompressedPageCache::Compress(const char *src, size_t size,
+                                   std::string &dst) {
+  int table[1 << LZ_HASH_BITS];
+  std::fill(table, table + (1 << LZ_HASH_BITS), -1);
+  dst.clear();
+  size_t i = 0, literal_start = 0;
+  while(i + LZ_MIN_MATCH <= size){
+    uint32_t sequence;
+    memcpy(&sequence, src + i, sizeof(sequence));
+    uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+    int candidate = table[hash];
+    table[hash] = static_cast<int>(i);
+    if(candidate < 0 || i - static_cast<size_t>(candidate) > LZ_MAX_OFFSET ||
+       memcmp(src + candidate, src + i, LZ_MIN_MATCH) != 0){
+      i++;
+      continue;
+    }
+    size_t length = LZ_MIN_MATCH;
+    while(i + length < size && length < LZ_MAX_MATCH &&
+          src[candidate + length] == src[i + length])
+      length++;
+    AppendLiterals(src + literal_start, i - literal_start, dst);
+    size_t offset = i - static_cast<size_t>(candidate);
+    dst.push_back(static_cast<char>(128 + length - LZ_MIN_MATCH));
+    dst.push_back(static_cast<char>(offset & 0xff));
+    dst.push_back(static_cast<char>(offset >> 8));
+    i += length;
+    literal_start = i;
+    if(dst.size() >= size)
+      return false;
+  }
+  AppendLiterals(src + literal_start, size - literal_start, dst);
+  return dst.size() < size;
+}
+
+void CompressedPageCache::Decompress(const std::string &src, char *dst,
+                                     size_t size) {
+  size_t in = 0, out = 0;
+  while(in < src.size()){
+    unsigned char control = static_cast<unsigned char>(src[in++]);
+    if(control < 128){
+      size_t run = control + 1;
+      assert(in + run <= src.size() && out + run <= size);
+      memcpy(dst + out, src.data() + in, run);
+      in += run;
+      out += run;
+    } else{
+      size_t length = control - 128 + LZ_MIN_MATCH;
+      assert(in + 2 <= src.size());
+      size_t offset = static_cast<unsigned char>(src[in]) |
+                      static_cast<unsigned char>(src[in + 1]) << 8;
+      in += 2;
+      assert(offset > 0 && offset <= out && out + length <= size);
+      // byte by byte, the match may overlap what it writes
+      for(size_t k = 0; k < length; ++k, ++out)
+        dst[out] = dst[out - offset];
+    }
+  }
+  assert(out == size);
+}
+
+CompressedPageCache::~CompressedPageCache() {
+  if(compress_thread_ != nullptr){
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      compress_running_ = false;
+    }
+    compress_cv_.notify_all();
+    compress_thread_->join();
+    delete compress_thread_;
+  }
+}
+
+/*
+ * Compression happens before taking the latch
+ */
+void CompressedPageCache::Insert(page_id_t page_id, const char *page_data) {
+  Entry entry;
+  entry.page_id = page_id;
+  entry.staged = false;
+  entry.compressed = Compress(page_data, PAGE_SIZE, entry.data);
+  if(!entry.compressed)
+    entry.data.assign(page_data, PAGE_SIZE);
+  if(entry.data.size() > budget_)
+    return;
+  std::lock_guard<std::mutex> lock(latch_);
+  Store(std::move(entry));
+}
+
+/*
+ * Keep the raw page and queue it for the compress thread. The caller holds
+ * the buffer pool latch, so this only copies the page
+ */
+void CompressedPageCache::Stage(page_id_t page_id, const char *page_data) {
+  if(PAGE_SIZE > budget_)
+    return;
+  Entry entry;
+  entry.page_id = page_id;
+  entry.compressed = false;
+  entry.staged = true;
+  entry.data.assign(page_data, PAGE_SIZE);
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    Store(std::move(entry));
+    staged_.emplace_back(page_id, entries_.back().version);
+    if(compress_thread_ == nullptr){
+      compress_running_ = true;
+      compress_thread_ =
+          new std::thread(&CompressedPageCache::RunCompressor, this);
+    }
+  }
+  compress_cv_.notify_one();
+}
+
+void CompressedPageCache::WaitForCompression() {
+  std::unique_lock<std::mutex> lock(latch_);
+  compressed_cv_.wait(lock,
+                      [this] { return staged_.empty() && !compressing_; });
+}
+
+/*
+ * Compress the pages queued by Stage(), outside latch_. A page handed out,
+ * dropped or replaced meanwhile is left alone: its version no longer matches
+ */
+void CompressedPageCache::RunCompressor() {
+  std::unique_lock<std::mutex> lock(latch_);
+  std::string raw, compressed;
+  while(true){
+    compress_cv_.wait(lock,
+                      [this] { return !staged_.empty() || !compress_running_; });
+    if(!compress_running_)
+      return;
+    auto staged = staged_.front();
+    staged_.pop_front();
+    auto found = index_.find(staged.first);
+    if(found == index_.end() || !found->second->staged ||
+       found->second->version != staged.second){
+      if(staged_.empty())
+        compressed_cv_.notify_all();
+      continue;
+    }
+    raw = found->second->data;
+    compressing_ = true;
+    lock.unlock();
+    bool is_compressed = Compress(raw.data(), PAGE_SIZE, compressed);
+    lock.lock();
+    compressing_ = false;
+    found = index_.find(staged.first);
+    if(found != index_.end() && found->second->staged &&
+       found->second->version == staged.second){
+      Entry &entry = *found->second;
+      entry.staged = false;
+      if(is_compressed){
+        size_ -= entry.data.size();
+        entry.data.swap(compressed);
+        entry.compressed = true;
+        size_ += entry.data.size();
+      }
+    }
+    if(staged_.empty())
+      compressed_cv_.notify_all();
+  }
+}
+
+bool CompressedPageCache::Lookup(page_id_t page_id, char *page_data) {
+  Entry entry;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    auto found = index_.find(page_id);
+    if(found == index_.end()){
+      misses_++;
+      return false;
+    }
+    entry = std::move(*found->second);
+    size_ -= entry.data.size();
+    entries_.erase(found->second);
+    index_.erase(found);
+  }
+  hits_++;
+  if(entry.compressed)
+    Decompress(entry.data, page_data, PAGE_SIZE);
+  else
+    memcpy(page_data, entry.data.data(), PAGE_SIZE);
+  return true;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto found = index_.find(page_id);
+  if(found != index_.end())
+    EraseEntry(found->second);
+}
+
+/*
+ * latch_ held. An older copy of the page is replaced, then the least recently
+ * stored pages are dropped until the cache is within its budget again
+ */
+void CompressedPageCache::Store(Entry &&entry) {
+  auto found = index_.find(entry.page_id);
+  if(found != index_.end())
+    EraseEntry(found->second);
+  entry.version = next_version_++;
+  size_ += entry.data.size();
+  entries_.push_back(std::move(entry));
+  index_[entries_.back().page_id] = std::prev(entries_.end());
+  while(size_ > budget_)
+    EraseEntry(entries_.begin());
+}
+
+size_t CompressedPageCache::GetSize() {
+  std::lock_guard<std::mutex> lock(latch_);
+  return size_;
+}
+
+size_t CompressedPageCache::GetNumPages() {
+  std::lock_guard<std::mutex> lock(latch_);
+  return entries_.size();
+}
+
+// latch_ held
+void CompressedPageCache::EraseEntry(std::list<Entry>::iterator it) {
+  size_ -= it->data.size();
+  index_.erase(it->page_id);
+  entries_.erase(it);
+}
+
+} // namespace cmudb
@@ -0,0 +1,213 @@
+/**
+ * flash_cache.cpp
+ */
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "buffer/flash_cache.h"
+#include "common/logger.h"
+
+namespace cmudb {
+
+/*
+ * Create the cache file, truncating what a previous run left: its slot map
+ * is gone
+ */
+FlashCache::FlashCache(const std::string &file_name, size_t num_slots)
+    : file_name_(file_name), slot_pages_(num_slots, INVALID_PAGE_ID),
+      slot_users_(num_slots, 0), next_slot_(0), next_version_(0),
+      writer_thread_(nullptr), writer_running_(false), writing_(0) {
+  assert(num_slots > 0);
+  fd_ = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(fd_ < 0){
+    LOG_DEBUG("can't open flash cache file %s", file_name.c_str());
+  }
+}
+
+FlashCache::~FlashCache() {
+  if(writer_thread_ != nullptr){
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      writer_running_ = false;
+    }
+    writer_cv_.notify_all();
+    writer_thread_->join();
+    delete writer_thread_;
+  }
+  if(fd_ >= 0)
+    close(fd_);
+}
+
+/*
+ * Write the page in the caller's thread. latch_ is not held for the write
+ */
+void FlashCache::Insert(page_id_t page_id, const char *page_data) {
+  std::unique_lock<std::mutex> lock(latch_);
+  if(AddPending(page_id, page_data))
+    WriteSlot(page_id, lock);
+}
+
+/*
+ * Copy the page and queue it for the writer thread. The caller holds the
+ * buffer pool latch, so this does no I/O
+ */
+void FlashCache::Stage(page_id_t page_id, const char *page_data) {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    if(!AddPending(page_id, page_data))
+      return;
+    staged_.push_back(page_id);
+    if(writer_thread_ == nullptr){
+      writer_running_ = true;
+      writer_thread_ = new std::thread(&FlashCache::RunWriter, this);
+    }
+  }
+  writer_cv_.notify_one();
+}
+
+void FlashCache::WaitForWrites() {
+  std::unique_lock<std::mutex> lock(latch_);
+  written_cv_.wait(lock, [this] { return staged_.empty() && writing_ == 0; });
+}
+
+/*
+ * Served from memory while pending, read from its slot otherwise. The slot is
+ * marked busy for the read, so it is not handed to another page meanwhile. A
+ * copy whose LSN is not the one it was written with is corrupt: dropped
+ * instead of served
+ */
+bool FlashCache::Lookup(page_id_t page_id, char *page_data) {
+  std::unique_lock<std::mutex> lock(latch_);
+  auto pending = pending_.find(page_id);
+  if(pending != pending_.end()){
+    memcpy(page_data, pending->second.data.data(), PAGE_SIZE);
+    hits_++;
+    return true;
+  }
+  auto found = index_.find(page_id);
+  if(found == index_.end()){
+    misses_++;
+    return false;
+  }
+  Entry entry = found->second;
+  slot_users_[entry.slot]++;
+  lock.unlock();
+  ssize_t read_count = pread(fd_, page_data, PAGE_SIZE,
+                             static_cast<off_t>(entry.slot) * PAGE_SIZE);
+  lock.lock();
+  slot_users_[entry.slot]--;
+  found = index_.find(page_id);
+  // dropped meanwhile, the disk copy may be changing
+  if(found == index_.end() || found->second.version != entry.version){
+    memset(page_data, 0, PAGE_SIZE);
+    misses_++;
+    return false;
+  }
+  if(read_count != PAGE_SIZE || PageLSN(page_data) != entry.written_lsn){
+    LOG_DEBUG("dropping unreadable flash cache copy of page %d", page_id);
+    memset(page_data, 0, PAGE_SIZE);
+    slot_pages_[entry.slot] = INVALID_PAGE_ID;
+    index_.erase(found);
+    misses_++;
+    return false;
+  }
+  hits_++;
+  return true;
+}
+
+void FlashCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  pending_.erase(page_id);
+  auto found = index_.find(page_id);
+  if(found == index_.end())
+    return;
+  slot_pages_[found->second.slot] = INVALID_PAGE_ID;
+  index_.erase(found);
+}
+
+size_t FlashCache::GetNumPages() {
+  std::lock_guard<std::mutex> lock(latch_);
+  return index_.size() + pending_.size();
+}
+
+/*
+ * latch_ held. Copy page_id into pending_, return false if the cache already
+ * holds it or has no file
+ */
+bool FlashCache::AddPending(page_id_t page_id, const char *page_data) {
+  if(fd_ < 0 || index_.count(page_id) == 1 || pending_.count(page_id) == 1)
+    return false;
+  PendingPage &pending = pending_[page_id];
+  pending.version = next_version_++;
+  pending.data.assign(page_data, PAGE_SIZE);
+  return true;
+}
+
+/*
+ * latch_ held through lock, released for the write. The slot at the head of
+ * the ring, or the next one without I/O in flight, is taken from the page it
+ * held and reserved. The page is installed in it unless it was dropped (or
+ * staged again) while being written, then the slot stays empty
+ */
+void FlashCache::WriteSlot(page_id_t page_id,
+                           std::unique_lock<std::mutex> &lock) {
+  auto pending = pending_.find(page_id);
+  if(pending == pending_.end())
+    return;
+  size_t slot = next_slot_, tries = 0;
+  while(slot_users_[slot] > 0){
+    slot = (slot + 1) % slot_pages_.size();
+    if(++tries == slot_pages_.size()){
+      pending_.erase(pending);
+      return;
+    }
+  }
+  next_slot_ = (slot + 1) % slot_pages_.size();
+  if(slot_pages_[slot] != INVALID_PAGE_ID)
+    index_.erase(slot_pages_[slot]);
+  slot_pages_[slot] = INVALID_PAGE_ID;
+  slot_users_[slot]++;
+  uint64_t version = pending->second.version;
+  std::string data = pending->second.data;
+  lock.unlock();
+  ssize_t written = pwrite(fd_, data.data(), PAGE_SIZE,
+                           static_cast<off_t>(slot) * PAGE_SIZE);
+  lock.lock();
+  slot_users_[slot]--;
+  pending = pending_.find(page_id);
+  if(pending == pending_.end() || pending->second.version != version)
+    return;
+  pending_.erase(pending);
+  if(written != PAGE_SIZE){
+    LOG_DEBUG("I/O error while writing flash cache slot %zu", slot);
+    return;
+  }
+  slot_pages_[slot] = page_id;
+  index_[page_id] = {slot, PageLSN(data.data()), version};
+  writes_++;
+}
+
+/*
+ * Write the pages queued by Stage(). A page dropped before its turn is
+ * skipped, pages still queued at shutdown are not written
+ */
+void FlashCache::RunWriter() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while(true){
+    writer_cv_.wait(lock,
+                    [this] { return !staged_.empty() || !writer_running_; });
+    if(!writer_running_)
+      return;
+    page_id_t page_id = staged_.front();
+    staged_.pop_front();
+    writing_++;
+    WriteSlot(page_id, lock);
+    writing_--;
+    if(staged_.empty() && writing_ == 0)
+      written_cv_.notify_all();
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,188 @@
+/**
+ * frame_arena.cpp
+ */
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "buffer/frame_arena.h"
+#include "common/logger.h"
+
+namespace cmudb {
+
+static_assert(PAGE_SIZE % DIRECT_IO_ALIGNMENT == 0,
+              "frames cut from an aligned region must stay aligned");
+
+FrameArena::FrameArena()
+    : huge_page_bytes_(0), mapped_bytes_(0),
+      os_page_size_(static_cast<size_t>(sysconf(_SC_PAGESIZE))) {}
+
+FrameArena::~FrameArena() {
+  for(auto &region : regions_)
+    free(region.first);
+}
+
+/*
+ * Allocate one region holding the frames missing, aligned to a huge page if
+ * it spans at least one, and to the sector size otherwise
+ */
+void FrameArena::Reserve(size_t count) {
+  if(spare_.size() >= count)
+    return;
+  size_t missing = count - spare_.size();
+  size_t bytes = missing * PAGE_SIZE;
+  bool huge = bytes >= HUGE_PAGE_SIZE;
+  size_t alignment = huge ? HUGE_PAGE_SIZE : DIRECT_IO_ALIGNMENT;
+  if(huge)
+    bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  void *memory = nullptr;
+  if(posix_memalign(&memory, alignment, bytes) != 0)
+    throw std::bad_alloc();
+  char *base = static_cast<char *>(memory);
+  Region &region = regions_[base];
+  region.bytes = bytes;
+  region.huge = false;
+  region.num_spare = missing;
+  region.spare.assign(missing, true);
+  region.first_page = (reinterpret_cast<uintptr_t>(base) + os_page_size_ -
+                       1) / os_page_size_ * os_page_size_;
+  uintptr_t end = reinterpret_cast<uintptr_t>(base) + bytes;
+  region.returned.assign(end > region.first_page
+                             ? (end - region.first_page) / os_page_size_
+                             : 0,
+                         false);
+  mapped_bytes_ += bytes;
+#ifdef MADV_HUGEPAGE
+  if(huge){
+    if(madvise(memory, bytes, MADV_HUGEPAGE) == 0){
+      region.huge = true;
+      huge_page_bytes_ += bytes;
+    } else {
+      LOG_DEBUG("no transparent huge pages for the frames");
+    }
+  }
+#endif
+  // hand out the frames in address order
+  for(size_t i = missing; i > 0; --i)
+    spare_.push_back(base + (i - 1) * PAGE_SIZE);
+}
+
+/*
+ * A kernel page of the frame that was advised away is mapped again by the
+ * first touch, it counts as mapped from here on
+ */
+char *FrameArena::Allocate() {
+  assert(!spare_.empty());
+  char *frame = spare_.back();
+  spare_.pop_back();
+  auto it = FindRegion(frame);
+  Region &region = it->second;
+  region.spare[(frame - it->first) / PAGE_SIZE] = false;
+  region.num_spare--;
+  size_t first, last;
+  OverlappingPages(region, frame, first, last);
+  for(size_t i = first; i < last; ++i){
+    if(region.returned[i]){
+      region.returned[i] = false;
+      mapped_bytes_ += os_page_size_;
+    }
+  }
+  return frame;
+}
+
+/*
+ * Keep the frame for the next growth, and give its memory back: the whole
+ * region once all of its frames are spare, the kernel pages around the frame
+ * whose frames are all spare otherwise
+ */
+void FrameArena::Free(char *frame) {
+  auto it = FindRegion(frame);
+  Region &region = it->second;
+  region.spare[(frame - it->first) / PAGE_SIZE] = true;
+  region.num_spare++;
+  spare_.push_back(frame);
+  if(region.num_spare == region.spare.size())
+    ReleaseRegion(it);
+  else
+    ReturnPages(it->first, region, frame);
+}
+
+std::map<char *, FrameArena::Region>::iterator
+FrameArena::FindRegion(char *frame) {
+  auto it = regions_.upper_bound(frame);
+  assert(it != regions_.begin());
+  --it;
+  assert(frame < it->first + it->second.bytes);
+  return it;
+}
+
+/*
+ * Kernel pages [first, last) of the region overlapping frame
+ */
+void FrameArena::OverlappingPages(const Region &region, char *frame,
+                                  size_t &first, size_t &last) const {
+  uintptr_t start = reinterpret_cast<uintptr_t>(frame);
+  uintptr_t end = start + PAGE_SIZE;
+  first = start < region.first_page
+              ? 0
+              : (start - region.first_page) / os_page_size_;
+  last = end <= region.first_page
+             ? 0
+             : (end - 1 - region.first_page) / os_page_size_ + 1;
+  last = std::min(last, region.returned.size());
+}
+
+/*
+ * Advise away the kernel pages overlapping frame whose frames are all spare.
+ * Only the kernel pages lying entirely in the region are touched
+ */
+void FrameArena::ReturnPages(char *base, Region &region, char *frame) {
+  uintptr_t region_start = reinterpret_cast<uintptr_t>(base);
+  size_t first, last;
+  OverlappingPages(region, frame, first, last);
+  for(size_t i = first; i < last; ++i){
+    uintptr_t page = region.first_page + i * os_page_size_;
+    if(region.returned[i])
+      continue;
+    size_t first_frame = (page - region_start) / PAGE_SIZE;
+    size_t last_frame = std::min(
+        (page + os_page_size_ - 1 - region_start) / PAGE_SIZE,
+        region.spare.size() - 1);
+    bool all_spare = true;
+    for(size_t f = first_frame; f <= last_frame && all_spare; ++f)
+      all_spare = region.spare[f];
+    if(!all_spare)
+      continue;
+    if(madvise(reinterpret_cast<void *>(page), os_page_size_,
+               MADV_DONTNEED) == 0){
+      region.returned[i] = true;
+      mapped_bytes_ -= os_page_size_;
+    }
+  }
+}
+
+/*
+ * Free a region all of whose frames are spare, and forget its frames
+ */
+void FrameArena::ReleaseRegion(std::map<char *, Region>::iterator it) {
+  char *base = it->first;
+  char *end = base + it->second.bytes;
+  spare_.erase(std::remove_if(spare_.begin(), spare_.end(),
+                              [base, end](char *frame) {
+                                return frame >= base && frame < end;
+                              }),
+               spare_.end());
+  size_t returned = std::count(it->second.returned.begin(),
+                               it->second.returned.end(), true);
+  mapped_bytes_ -= it->second.bytes - returned * os_page_size_;
+  if(it->second.huge)
+    huge_page_bytes_ -= it->second.bytes;
+  free(base);
+  regions_.erase(it);
+}
+
+} // namespace cmudb
@@ -0,0 +1,128 @@
+/**
+ * LRU-K implementation
+ */
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+// access history is tracked per page, a frame holds different pages over time
+static inline int64_t HistoryKey(Page *page) { return page->GetPageId(); }
+// test only
+static inline int64_t HistoryKey(int value) { return value; }
+
+template <typename T>
+LRUKReplacer<T>::LRUKReplacer(size_t k, size_t history_size,
+                              uint64_t correlated_period)
+    : k_(k), history_size_(history_size),
+      correlated_period_(correlated_period), current_tick_(0) {}
+
+template <typename T> LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Record one access of value and make it evictable
+ */
+template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  int64_t key = HistoryKey(value);
+  uint64_t tick = ++current_tick_;
+  History &history = history_[key];
+  if(history.retired){
+    retired_.erase(history.retired_pos);
+    history.retired = false;
+  }
+  auto &accesses = history.accesses;
+  if(!accesses.empty() && tick - accesses.back() <= correlated_period_)
+    // correlated reference, still one access
+    accesses.back() = tick;
+  else{
+    accesses.push_back(tick);
+    if(accesses.size() > k_)
+      accesses.pop_front();
+  }
+
+  auto it = position_.find(value);
+  if(it != position_.end())
+    evictable_.erase(it->second.order);
+  order_t order = OrderOf(history);
+  evictable_[order] = value;
+  position_[value] = Entry{order, key};
+}
+
+/* Pop the value with the largest backward K-distance to argument "value", and
+ * return true. If no value is evictable, return false
+ */
+template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if(evictable_.empty())
+    return false;
+  auto it = evictable_.begin();
+  value = it->second;
+  evictable_.erase(it);
+  auto pos = position_.find(value);
+  Retire(pos->second.key);
+  position_.erase(pos);
+  return true;
+}
+
+/*
+ * Remove value from the evictable set, its history is kept. If removal is
+ * successful, return true, otherwise return false
+ */
+template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto pos = position_.find(value);
+  if(pos == position_.end())
+    return false;
+  evictable_.erase(pos->second.order);
+  Retire(pos->second.key);
+  position_.erase(pos);
+  return true;
+}
+
+/*
+ * Append up to n values with the largest backward K-distance to "values"
+ */
+template <typename T>
+void LRUKReplacer<T>::PeekVictims(size_t n, std::vector<T> &values) {
+  std::lock_guard<std::mutex> guard(latch_);
+  for(auto it = evictable_.begin(); it != evictable_.end() && n > 0;
+      ++it, --n)
+    values.push_back(it->second);
+}
+
+template <typename T> size_t LRUKReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return evictable_.size();
+}
+
+/*
+ * Keep the history of a page that left the evictable set, forget the oldest
+ * retired history once more than history_size_ are kept
+ */
+template <typename T> void LRUKReplacer<T>::Retire(int64_t key) {
+  History &history = history_[key];
+  if(!history.retired){
+    history.retired = true;
+    history.retired_pos = retired_.insert(retired_.end(), key);
+  }
+  while(retired_.size() > history_size_){
+    history_.erase(retired_.front());
+    retired_.pop_front();
+  }
+}
+
+template <typename T>
+typename LRUKReplacer<T>::order_t
+LRUKReplacer<T>::OrderOf(const History &history) {
+  // front is the K-th most recent access once K accesses are recorded,
+  // otherwise the first recorded access
+  return order_t(history.accesses.size() >= k_ ? 1 : 0,
+                 history.accesses.front());
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace cmudb
@@ -1,47 +1,84 @@
 /**
  * LRU implementation
  */
+#include <algorithm>
+
 #include "buffer/lru_replacer.h"
 #include "page/page.h"
 
 namespace cmudb {
 
-template <typename T> LRUReplacer<T>::LRUReplacer() {
-  deque_ = new std::deque<T>;
-  lk_ = new WfirstRWLock();
+template <typename T> const size_t LRUReplacer<T>::NIL;
+template <typename T> const size_t LRUReplacer<T>::NOT_LISTED;
+
+template <typename T>
+LRUReplacer<T>::LRUReplacer(size_t num_frames)
+    : head_(NIL), tail_(NIL), size_(0) {
+  Grow(num_frames);
 }
 
-template <typename T> LRUReplacer<T>::~LRUReplacer() {
-  delete deque_;
-  delete lk_;
+template <typename T> LRUReplacer<T>::~LRUReplacer() {}
+
+/*
+ * Make room for frame numbers below num_frames, none of them listed
+ */
+template <typename T> void LRUReplacer<T>::Grow(size_t num_frames) {
+  if(num_frames <= prev_.size())
+    return;
+  values_.resize(num_frames);
+  prev_.resize(num_frames, NOT_LISTED);
+  next_.resize(num_frames, NIL);
+}
+
+/*
+ * Take a listed frame out of the list
+ */
+template <typename T> void LRUReplacer<T>::Unlink(size_t frame) {
+  if(prev_[frame] == NIL)
+    head_ = next_[frame];
+  else
+    next_[prev_[frame]] = next_[frame];
+  if(next_[frame] == NIL)
+    tail_ = prev_[frame];
+  else
+    prev_[next_[frame]] = prev_[frame];
+  prev_[frame] = NOT_LISTED;
+  next_[frame] = NIL;
+  size_--;
 }
 
 /*
  * Insert value into LRU
+ * if value is already in LRU, move it to the most recently used end
  */
 template <typename T> void LRUReplacer<T>::Insert(const T &value) {
-  unique_writeguard<WfirstRWLock> lk(*lk_);
-  auto it = deque_->begin();
-  while(it != deque_->end())
-    if(*it++ == value){
-      deque_->erase(--it);
-      break;
-    }
-  deque_->push_back(value);
+  size_t frame = FrameOf(value);
+  std::lock_guard<std::mutex> guard(latch_);
+  if(frame >= prev_.size())
+    Grow(std::max(frame + 1, 2 * prev_.size()));
+  if(prev_[frame] != NOT_LISTED)
+    Unlink(frame);
+  values_[frame] = value;
+  prev_[frame] = tail_;
+  next_[frame] = NIL;
+  if(tail_ == NIL)
+    head_ = frame;
+  else
+    next_[tail_] = frame;
+  tail_ = frame;
+  size_++;
 }
 
 /* If LRU is non-empty, pop the head member from LRU to argument "value", and
  * return true. If LRU is empty, return false
  */
 template <typename T> bool LRUReplacer<T>::Victim(T &value) {
-  unique_writeguard<WfirstRWLock> lk(*lk_);
-  size_t deque_size = deque_->size();
-  if(deque_size != 0){
-    value = *(deque_->begin());
-    deque_->pop_front();
-    return true;
-  }
-  return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  if(head_ == NIL)
+    return false;
+  value = values_[head_];
+  Unlink(head_);
+  return true;
 }
 
 /*
@@ -49,20 +86,27 @@ template <typename T> bool LRUReplacer<T>::Victim(T &value) {
  * return false
  */
 template <typename T> bool LRUReplacer<T>::Erase(const T &value) {
-  unique_writeguard<WfirstRWLock> lk(*lk_);
-  auto it = deque_->begin();
-  while(it != deque_->end())
-    if(*it++ == value){
-      deque_->erase(--it);
-      return true;
-    }
-  return false;
+  size_t frame = FrameOf(value);
+  std::lock_guard<std::mutex> guard(latch_);
+  if(frame >= prev_.size() || prev_[frame] == NOT_LISTED)
+    return false;
+  Unlink(frame);
+  return true;
+}
+
+/*
+ * Append up to n least recently unpinned values to "values"
+ */
+template <typename T>
+void LRUReplacer<T>::PeekVictims(size_t n, std::vector<T> &values) {
+  std::lock_guard<std::mutex> guard(latch_);
+  for(size_t frame = head_; frame != NIL && n > 0; frame = next_[frame], --n)
+    values.push_back(values_[frame]);
 }
 
-template <typename T> size_t LRUReplacer<T>::Size() { 
-  unique_readguard<WfirstRWLock> lk(*lk_);
-  size_t deque_size = deque_->size();
-  return deque_size; 
+template <typename T> size_t LRUReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return size_;
 }
 
 template class LRUReplacer<Page *>;
@@ -0,0 +1,67 @@
+/**
+ * page_guard.cpp
+ */
+#include <utility>
+
+#include "buffer/page_guard.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+PageGuard::PageGuard(PageGuard &&other)
+    : buffer_pool_manager_(other.buffer_pool_manager_), page_(other.page_),
+      is_dirty_(other.is_dirty_) {
+  other.page_ = nullptr;
+  other.is_dirty_ = false;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&other) {
+  if (this != &other) {
+    Release();
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = other.page_;
+    is_dirty_ = other.is_dirty_;
+    other.page_ = nullptr;
+    other.is_dirty_ = false;
+  }
+  return *this;
+}
+
+void PageGuard::Release() {
+  if (page_ == nullptr)
+    return;
+  buffer_pool_manager_->UnpinPage(page_, is_dirty_);
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&other) {
+  // unlatch before PageGuard drops the pin of the old page
+  if (this != &other)
+    Release();
+  PageGuard::operator=(std::move(other));
+  return *this;
+}
+
+void ReadPageGuard::Release() {
+  if (page_ == nullptr)
+    return;
+  page_->RUnlatch();
+  PageGuard::Release();
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&other) {
+  if (this != &other)
+    Release();
+  PageGuard::operator=(std::move(other));
+  return *this;
+}
+
+void WritePageGuard::Release() {
+  if (page_ == nullptr)
+    return;
+  page_->WUnlatch();
+  PageGuard::Release();
+}
+
+} // namespace cmudb
@@ -0,0 +1,260 @@
+#include <cassert>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+namespace cmudb {
+
+/*
+ * ParallelBufferPoolManager Constructor
+ * Create num_instances buffer pool instances of pool_size frames each, all on
+ * the same disk manager and log manager
+ */
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances,
+                                                     size_t pool_size,
+                                                     DiskManager *disk_manager,
+                                                     LogManager *log_manager,
+                                                     ReplacerType replacer_type,
+                                                     HashTableType page_table_type)
+    : num_instances_(num_instances), pool_size_(pool_size),
+      disk_manager_(disk_manager), spare_ids_(num_instances) {
+  assert(num_instances_ > 0);
+  for (size_t i = 0; i < num_instances_; ++i)
+    instances_.push_back(new BufferPoolManagerInstance(pool_size_, disk_manager,
+                                                       log_manager,
+                                                       replacer_type,
+                                                       page_table_type));
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  for (auto instance : instances_)
+    delete instance;
+}
+
+// the instance responsible for page_id
+BufferPoolManagerInstance *
+ParallelBufferPoolManager::GetInstance(page_id_t page_id) {
+  return instances_[page_id % num_instances_];
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id,
+                                           BufferAccessStrategy *strategy,
+                                           PageClass page_class) {
+  return GetInstance(page_id)->FetchPage(page_id, strategy, page_class);
+}
+
+Page *ParallelBufferPoolManager::FetchPageIfResident(page_id_t page_id) {
+  return GetInstance(page_id)->FetchPageIfResident(page_id);
+}
+
+size_t ParallelBufferPoolManager::FetchPages(const page_id_t *page_ids,
+                                             size_t count, Page **pages) {
+  std::vector<std::vector<page_id_t>> instance_ids(num_instances_);
+  std::vector<std::vector<size_t>> positions(num_instances_);
+  for (size_t i = 0; i < count; ++i) {
+    size_t instance = page_ids[i] % num_instances_;
+    instance_ids[instance].push_back(page_ids[i]);
+    positions[instance].push_back(i);
+  }
+  size_t fetched = 0;
+  std::vector<Page *> instance_pages;
+  for (size_t instance = 0; instance < num_instances_; ++instance) {
+    if (instance_ids[instance].empty())
+      continue;
+    instance_pages.resize(instance_ids[instance].size());
+    fetched += instances_[instance]->FetchPages(instance_ids[instance].data(),
+                                                instance_ids[instance].size(),
+                                                instance_pages.data());
+    for (size_t j = 0; j < instance_pages.size(); ++j)
+      pages[positions[instance][j]] = instance_pages[j];
+  }
+  return fetched;
+}
+
+Page *ParallelBufferPoolManager::FetchChild(Page *parent, page_id_t child_id) {
+  BufferPoolManagerInstance *instance = GetInstance(child_id);
+  // swips of a frame are protected by the latch of its own instance
+  if (instance != GetInstance(parent->GetPageId()))
+    return instance->FetchPage(child_id);
+  return instance->FetchChild(parent, child_id);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(Page *page, bool is_dirty) {
+  return GetInstance(page->GetPageId())->UnpinPage(page, is_dirty);
+}
+
+void ParallelBufferPoolManager::Prefetch(page_id_t page_id,
+                                         BufferAccessStrategy *strategy) {
+  if (page_id == INVALID_PAGE_ID)
+    return;
+  GetInstance(page_id)->Prefetch(page_id, strategy);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID)
+    return false;
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+size_t ParallelBufferPoolManager::FlushAllPages() {
+  size_t flushed = 0;
+  for (auto instance : instances_)
+    flushed += instance->FlushAllPages();
+  return flushed;
+}
+
+size_t ParallelBufferPoolManager::FlushPages(page_id_t first_page_id,
+                                             page_id_t last_page_id) {
+  size_t flushed = 0;
+  for (auto instance : instances_)
+    flushed += instance->FlushPages(first_page_id, last_page_id);
+  return flushed;
+}
+
+/*
+ * Create the page in the instance its id maps to. Ids of spare_ids_ come
+ * first, one of each instance not tried yet, then new ids from disk manager.
+ * If all the pages of the instance are pinned, the id is kept in spare_ids_
+ * for a later NewPage, it is not lost and leaves no hole in the file once it
+ * is used. A new id of an instance already tried is kept the same way, the
+ * next one maps to the next instance. Under concurrent allocation, ids may
+ * keep hitting tried instances, so at most 2 * num_instances ids are taken
+ * from disk manager.
+ * return nullptr if all the pages of all the instances are pinned
+ */
+Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id,
+                                         PageClass page_class) {
+  std::vector<bool> tried(num_instances_, false);
+  size_t num_tried = 0;
+  size_t num_allocated = 0;
+  while (num_tried < num_instances_ && num_allocated < 2 * num_instances_) {
+    page_id_t new_page_id;
+    if (!TakeSpareId(tried, new_page_id)) {
+      new_page_id = disk_manager_->AllocatePage();
+      num_allocated++;
+      if (tried[new_page_id % num_instances_]) {
+        GiveBackId(new_page_id);
+        continue;
+      }
+    }
+    size_t instance = new_page_id % num_instances_;
+    Page *p =
+        instances_[instance]->CreatePage(new_page_id, page_class, false);
+    if (p != nullptr) {
+      page_id = new_page_id;
+      return p;
+    }
+    GiveBackId(new_page_id);
+    tried[instance] = true;
+    num_tried++;
+  }
+  return nullptr;
+}
+
+// a spare id of an instance not tried yet, false if there is none
+bool ParallelBufferPoolManager::TakeSpareId(const std::vector<bool> &tried,
+                                            page_id_t &page_id) {
+  std::lock_guard<std::mutex> lock(spare_latch_);
+  for (size_t i = 0; i < num_instances_; ++i) {
+    if (tried[i] || spare_ids_[i].empty())
+      continue;
+    page_id = spare_ids_[i].back();
+    spare_ids_[i].pop_back();
+    return true;
+  }
+  return false;
+}
+
+void ParallelBufferPoolManager::GiveBackId(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(spare_latch_);
+  spare_ids_[page_id % num_instances_].push_back(page_id);
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+  return GetInstance(page_id)->DeletePage(page_id);
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() const {
+  size_t pool_size = 0;
+  for (auto instance : instances_)
+    pool_size += instance->GetPoolSize();
+  return pool_size;
+}
+
+/*
+ * new_size / num_instances frames per instance, the first
+ * new_size % num_instances instances get one more, so none is dropped
+ */
+size_t ParallelBufferPoolManager::Resize(size_t new_size) {
+  size_t pool_size = 0;
+  for (size_t i = 0; i < num_instances_; ++i)
+    pool_size += instances_[i]->Resize(new_size / num_instances_ +
+                                       (i < new_size % num_instances_ ? 1 : 0));
+  return pool_size;
+}
+
+void ParallelBufferPoolManager::StartCleaner(size_t target_clean_frames,
+                                             size_t max_writes_per_second) {
+  for (auto instance : instances_)
+    instance->StartCleaner(target_clean_frames, max_writes_per_second);
+}
+
+void ParallelBufferPoolManager::StopCleaner() {
+  for (auto instance : instances_)
+    instance->StopCleaner();
+}
+
+size_t ParallelBufferPoolManager::GetForegroundWrites() const {
+  size_t writes = 0;
+  for (auto instance : instances_)
+    writes += instance->GetForegroundWrites();
+  return writes;
+}
+
+size_t ParallelBufferPoolManager::GetBackgroundWrites() const {
+  size_t writes = 0;
+  for (auto instance : instances_)
+    writes += instance->GetBackgroundWrites();
+  return writes;
+}
+
+BufferPoolMetricsSnapshot ParallelBufferPoolManager::GetMetrics() {
+  BufferPoolMetricsSnapshot snapshot;
+  for (auto instance : instances_)
+    snapshot += instance->GetMetrics();
+  return snapshot;
+}
+
+void ParallelBufferPoolManager::EnableWarmUp(const std::string &file_name) {
+  for (size_t i = 0; i < num_instances_; ++i)
+    instances_[i]->EnableWarmUp(file_name + "." + std::to_string(i));
+}
+
+void ParallelBufferPoolManager::EnableCompressedCache(size_t budget) {
+  for (auto instance : instances_)
+    instance->EnableCompressedCache(budget);
+}
+
+void ParallelBufferPoolManager::EnableFlashCache(const std::string &file_name,
+                                                 size_t num_slots) {
+  for (size_t i = 0; i < num_instances_; ++i)
+    instances_[i]->EnableFlashCache(file_name + "." + std::to_string(i),
+                                    num_slots);
+}
+
+bool ParallelBufferPoolManager::DumpResidentPages() {
+  bool dumped = true;
+  for (auto instance : instances_)
+    dumped = instance->DumpResidentPages() && dumped;
+  return dumped;
+}
+
+void ParallelBufferPoolManager::WaitForWarmUp() {
+  for (auto instance : instances_)
+    instance->WaitForWarmUp();
+}
+
+} // namespace cmudb
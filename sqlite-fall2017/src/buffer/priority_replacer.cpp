@@ -0,0 +1,63 @@
+/**
+ * priority_replacer.cpp
+ */
+#include <cassert>
+
+#include "buffer/priority_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+PriorityReplacer<T>::PriorityReplacer(
+    const std::vector<Replacer<T> *> &replacers, size_t (*class_of)(const T &))
+    : replacers_(replacers), class_of_(class_of) {
+  assert(!replacers_.empty());
+}
+
+template <typename T> PriorityReplacer<T>::~PriorityReplacer() {
+  for (auto replacer : replacers_)
+    delete replacer;
+}
+
+template <typename T> void PriorityReplacer<T>::Insert(const T &value) {
+  size_t value_class = class_of_(value);
+  assert(value_class < replacers_.size());
+  replacers_[value_class]->Insert(value);
+}
+
+template <typename T> bool PriorityReplacer<T>::Victim(T &value) {
+  for (auto replacer : replacers_)
+    if (replacer->Victim(value))
+      return true;
+  return false;
+}
+
+template <typename T> bool PriorityReplacer<T>::Erase(const T &value) {
+  size_t value_class = class_of_(value);
+  assert(value_class < replacers_.size());
+  return replacers_[value_class]->Erase(value);
+}
+
+template <typename T>
+void PriorityReplacer<T>::PeekVictims(size_t n, std::vector<T> &values) {
+  size_t end = values.size() + n;
+  for (auto replacer : replacers_) {
+    if (values.size() >= end)
+      break;
+    replacer->PeekVictims(end - values.size(), values);
+  }
+}
+
+template <typename T> size_t PriorityReplacer<T>::Size() {
+  size_t size = 0;
+  for (auto replacer : replacers_)
+    size += replacer->Size();
+  return size;
+}
+
+template class PriorityReplacer<Page *>;
+// test only
+template class PriorityReplacer<int>;
+
+} // namespace cmudb
@@ -0,0 +1,57 @@
+/**
+ * read_ahead.cpp
+ */
+#include "buffer/read_ahead.h"
+
+namespace cmudb {
+
+/*
+ * 1. forget the pages the scan has reached
+ * 2. prefetch next if nothing is in flight
+ * 3. extend the window as far as the reads completed so far allow, see Poll()
+ */
+void ReadAhead::Advance(page_id_t current, page_id_t next) {
+  while (!in_flight_.empty()) {
+    page_id_t page_id = in_flight_.front();
+    in_flight_.pop_front();
+    if (page_id == current)
+      break;
+  }
+  chain_end_ = false;
+  if (window_ == 0 || next == INVALID_PAGE_ID)
+    return;
+  if (in_flight_.empty()) {
+    buffer_pool_manager_->Prefetch(next, strategy_);
+    in_flight_.push_back(next);
+  }
+  Poll();
+}
+
+/*
+ * While less than window pages are in flight, pin the last one if its read
+ * is complete, read the id of the page after it and prefetch that one. Stops
+ * at a page still being read, or being written, it is tried again next time
+ */
+void ReadAhead::Poll() {
+  while (!chain_end_ && !in_flight_.empty() && in_flight_.size() < window_) {
+    page_id_t tail = in_flight_.back();
+    Page *page = buffer_pool_manager_->FetchPageIfResident(tail);
+    if (page == nullptr)
+      return;
+    // a single field is read, optimistically
+    uint64_t version = page->OptimisticRead();
+    page_id_t after_tail = next_page_id_(page);
+    bool valid = page->Validate(version);
+    buffer_pool_manager_->UnpinPage(page, false);
+    if (!valid)
+      return;
+    if (after_tail == INVALID_PAGE_ID) {
+      chain_end_ = true;
+      return;
+    }
+    buffer_pool_manager_->Prefetch(after_tail, strategy_);
+    in_flight_.push_back(after_tail);
+  }
+}
+
+} // namespace cmudb
@@ -6,8 +6,12 @@
 
 namespace cmudb {
 
-LockManager::LockManager(bool strict_2PL) : strict_2PL_(strict_2PL){
-  lock_table_ = new ExtendibleHash<RID, TxnList*>(BUCKET_SIZE);
+LockManager::LockManager(bool strict_2PL, HashTableType lock_table_type)
+    : strict_2PL_(strict_2PL){
+  if(lock_table_type == HashTableType::LINEAR)
+    lock_table_ = new LinearHash<RID, TxnList*>(BUCKET_SIZE);
+  else
+    lock_table_ = new ExtendibleHash<RID, TxnList*>(BUCKET_SIZE, MERGE_FILL);
 }
 
 bool LockManager::LockShared(Transaction *txn, const RID &rid) {
@@ -17,14 +21,12 @@ bool LockManager::LockShared(Transaction *txn, const RID &rid) {
     return false;
   }
   // Get txn_list and lock on it
-  TxnList *txn_list;
-  if(!(lock_table_->Find(rid, txn_list))){
-    txn_list = new TxnList();
-    lock_table_->Insert(rid, txn_list);
-  }
+  TxnList *txn_list = AcquireList(rid, true);
   // unlocked or locked in shared mode: insert directly
   txn->GetSharedLockSet()->insert(rid);
-  if(txn_list->InsertRead(txn)){
+  bool granted = txn_list->InsertRead(txn);
+  ReleaseList(rid, txn_list);
+  if(granted){
     return true;
   }
   else{
@@ -39,13 +41,11 @@ bool LockManager::LockExclusive(Transaction *txn, const RID &rid) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  TxnList *txn_list;
-  if(!(lock_table_->Find(rid, txn_list))){
-    txn_list = new TxnList();
-    lock_table_->Insert(rid, txn_list);
-  }
+  TxnList *txn_list = AcquireList(rid, true);
   txn->GetExclusiveLockSet()->insert(rid);
-  if(txn_list->InsertWrite(txn))
+  bool granted = txn_list->InsertWrite(txn);
+  ReleaseList(rid, txn_list);
+  if(granted)
     return true;
   else{
     txn->GetExclusiveLockSet()->erase(rid);
@@ -59,20 +59,23 @@ bool LockManager::LockUpgrade(Transaction *txn, const RID &rid) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  TxnList *txn_list;
   // no lock record of rid in hash table, abort.
-  if(!(lock_table_->Find(rid, txn_list))){
+  TxnList *txn_list = AcquireList(rid, false);
+  if(txn_list == nullptr){
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // txn hasn't  get shared lock on rid, abort.
   LockType ltype;
   if(!(txn_list->Find(txn, ltype)) || ltype != LockType::SHARED){
+    ReleaseList(rid, txn_list);
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // try to insert exclusive lock
-  if(txn_list->UpgradeFromRToW(txn)){
+  bool granted = txn_list->UpgradeFromRToW(txn);
+  ReleaseList(rid, txn_list);
+  if(granted){
     return true;
   }
   else{
@@ -88,16 +91,49 @@ bool LockManager::Unlock(Transaction *txn, const RID &rid) {
   }
   if(!strict_2PL_ && txn->GetState() == TransactionState::GROWING)
     txn->SetState(TransactionState::SHRINKING);
-  TxnList *txn_list;
   // no lock record of rid in hash table, abort.
-  if(!(lock_table_->Find(rid, txn_list))){
+  TxnList *txn_list = AcquireList(rid, false);
+  if(txn_list == nullptr){
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  if(txn_list->Delete(txn))
-    return true;
-  else
-    return false;
+  bool deleted = txn_list->Delete(txn);
+  ReleaseList(rid, txn_list);
+  return deleted;
+}
+
+/*
+ * Find the list of rid, create it if create is set (return nullptr if there
+ * is none otherwise), and count the caller as a user until ReleaseList()
+ */
+LockManager::TxnList *LockManager::AcquireList(const RID &rid, bool create) {
+  std::lock_guard<std::mutex> lock(table_mutex_);
+  TxnList *txn_list;
+  if(!(lock_table_->Find(rid, txn_list))){
+    if(!create)
+      return nullptr;
+    txn_list = new TxnList();
+    lock_table_->Insert(rid, txn_list);
+  }
+  txn_list->users_++;
+  return txn_list;
+}
+
+/*
+ * The last user of a list with no request left removes the entry of rid, so
+ * the lock table shrinks back after a spike of locked tuples
+ */
+void LockManager::ReleaseList(const RID &rid, TxnList *txn_list) {
+  std::lock_guard<std::mutex> lock(table_mutex_);
+  if(--txn_list->users_ != 0 || !txn_list->IsEmpty())
+    return;
+  lock_table_->Remove(rid);
+  delete txn_list;
+}
+
+bool LockManager::TxnList::IsEmpty(){
+  std::unique_lock<std::mutex> lck(list_mutex_);
+  return GetHead() == nullptr;
 }
 
 bool LockManager::TxnList::Find(Transaction *txn, LockType &ltype){
@@ -233,6 +269,7 @@ bool LockManager::TxnList::Delete(Transaction *txn){
         SetHead(node->GetNext());
       else
         pre_node->SetNext(node->GetNext());
+      delete node;
       return true;
     }
     pre_node = node;
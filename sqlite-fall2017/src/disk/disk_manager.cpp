@@ -2,10 +2,17 @@
  * disk_manager.cpp
  */
 #include <assert.h>
+#include <cerrno>
+#include <cstdlib>
+#include <climits>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 #include "common/logger.h"
 #include "disk/disk_manager.h"
@@ -18,8 +25,10 @@ static char *buffer_used = nullptr;
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
+DiskManager::DiskManager(const std::string &db_file, bool direct_io)
+    : file_name_(db_file), db_fd_(-1), direct_io_(false), bounce_(nullptr),
+      next_page_id_(0),
+      num_flushes_(0), num_reads_(0), flush_log_(false),
       flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
@@ -53,9 +62,36 @@ DiskManager::DiskManager(const std::string &db_file)
     // reopen with original mode
     db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
   }
+  // pages already in the file are taken, new ones go after them
+  int file_size = GetFileSize(db_file);
+  if (file_size > 0)
+    next_page_id_ = file_size / PAGE_SIZE;
+
+  void *bounce = nullptr;
+  if (direct_io &&
+      posix_memalign(&bounce, DIRECT_IO_ALIGNMENT, PAGE_SIZE) == 0) {
+    bounce_ = static_cast<char *>(bounce);
+#ifdef O_DIRECT
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_DIRECT);
+#endif
+    direct_io_ = db_fd_ >= 0;
+  }
+  if (direct_io_) {
+    // some file systems only reject O_DIRECT transfers, not the open
+    std::lock_guard<std::mutex> lock(db_io_latch_);
+    DirectRead(HEADER_PAGE_ID, bounce_);
+  } else {
+    if (direct_io) {
+      LOG_DEBUG("O_DIRECT not supported, using buffered I/O");
+    }
+    db_fd_ = open(db_file.c_str(), O_RDWR);
+  }
 }
 
 DiskManager::~DiskManager() {
+  if (db_fd_ >= 0)
+    close(db_fd_);
+  free(bounce_);
   db_io_.close();
   log_io_.close();
 }
@@ -65,6 +101,9 @@ DiskManager::~DiskManager() {
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   size_t offset = page_id * PAGE_SIZE;
+  std::lock_guard<std::mutex> lock(db_io_latch_);
+  if (IsDirectIO() && DirectWrite(page_id, page_data))
+    return;
   // set write cursor to offset
   db_io_.seekp(offset);
   db_io_.write(page_data, PAGE_SIZE);
@@ -77,15 +116,54 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   db_io_.flush();
 }
 
+/**
+ * Write a batch of pages, as FlushAllPages of the buffer pool issues it. The
+ * ids are sorted, a run of consecutive ids (up to IOV_MAX pages) goes to disk
+ * in a single pwritev, and the batch needs no flush of db_io_ at all
+ */
+int DiskManager::WritePages(const page_id_t *page_ids,
+                            const char *const *page_data, int count) {
+  std::lock_guard<std::mutex> lock(db_io_latch_);
+  if (db_fd_ < 0) {
+    for (int i = 0; i < count; ++i) {
+      db_io_.seekp(static_cast<size_t>(page_ids[i]) * PAGE_SIZE);
+      db_io_.write(page_data[i], PAGE_SIZE);
+    }
+    if (db_io_.bad()) {
+      LOG_DEBUG("I/O error while writing");
+    }
+    db_io_.flush();
+    return count;
+  }
+  int writes = 0;
+  int end;
+  for (int begin = 0; begin < count; begin = end) {
+    assert(begin == 0 || page_ids[begin - 1] < page_ids[begin]);
+    end = begin + 1;
+    while (end < count && end - begin < IOV_MAX &&
+           page_ids[end] == page_ids[end - 1] + 1)
+      end++;
+    // a rejected O_DIRECT write is retried buffered
+    if (!WriteRun(page_ids + begin, page_data + begin, end - begin))
+      WriteRun(page_ids + begin, page_data + begin, end - begin);
+    writes++;
+  }
+  return writes;
+}
+
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   int offset = page_id * PAGE_SIZE;
+  std::lock_guard<std::mutex> lock(db_io_latch_);
+  num_reads_ += 1;
   // check if read beyond file length
   if (offset > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
+  } else if (IsDirectIO() && DirectRead(page_id, page_data)) {
+    return;
   } else {
     // set read cursor to offset
     db_io_.seekp(offset);
@@ -100,6 +178,42 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   }
 }
 
+/**
+ * Read a batch of pages under a single acquisition of the file latch. The ids
+ * are sorted, so the reads sweep the file in one direction, and the cursor is
+ * only moved where the ids are not consecutive
+ */
+void DiskManager::ReadPages(const page_id_t *page_ids, char *const *page_data,
+                            int count) {
+  std::lock_guard<std::mutex> lock(db_io_latch_);
+  num_reads_ += count;
+  int file_size = GetFileSize(file_name_);
+  page_id_t cursor = INVALID_PAGE_ID; // page the read cursor is at
+  for (int i = 0; i < count; ++i) {
+    assert(i == 0 || page_ids[i - 1] <= page_ids[i]);
+    int offset = page_ids[i] * PAGE_SIZE;
+    if (offset > file_size) {
+      LOG_DEBUG("I/O error while reading");
+      continue;
+    }
+    if (IsDirectIO() && DirectRead(page_ids[i], page_data[i]))
+      continue;
+    if (page_ids[i] != cursor) {
+      db_io_.clear();
+      db_io_.seekp(offset);
+    }
+    db_io_.read(page_data[i], PAGE_SIZE);
+    int read_count = db_io_.gcount();
+    if (read_count < PAGE_SIZE) {
+      LOG_DEBUG("Read less than a page");
+      memset(page_data[i] + read_count, 0, PAGE_SIZE - read_count);
+      cursor = INVALID_PAGE_ID;
+    } else {
+      cursor = page_ids[i] + 1;
+    }
+  }
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -158,7 +272,8 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * For now just keep an increasing counter, starting after the last page of
+ * the file. Safe to call from several buffer pool instances at once
  */
 page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
 
@@ -175,11 +290,108 @@ void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
  */
 int DiskManager::GetNumFlushes() const { return num_flushes_; }
 
+/**
+ * Returns number of page reads made so far
+ */
+int DiskManager::GetNumReads() const { return num_reads_; }
+
 /**
  * Returns true if the log is currently being flushed
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Private helpers of direct I/O, called holding db_io_latch_. A buffer that
+ * is not aligned for O_DIRECT is copied through bounce_. EINVAL means the file
+ * system refuses the transfer: direct I/O is turned off and the caller redoes
+ * the transfer buffered. Other errors are reported like buffered ones
+ */
+bool DiskManager::DirectRead(page_id_t page_id, char *page_data) {
+  char *buffer =
+      reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0
+          ? page_data
+          : bounce_;
+  ssize_t read_count = pread(db_fd_, buffer, PAGE_SIZE,
+                             static_cast<off_t>(page_id) * PAGE_SIZE);
+  if (read_count < 0) {
+    if (errno == EINVAL) {
+      LOG_DEBUG("O_DIRECT rejected, falling back to buffered I/O");
+      DisableDirectIO();
+      return false;
+    }
+    LOG_DEBUG("I/O error while reading");
+    read_count = 0;
+  }
+  if (read_count < PAGE_SIZE)
+    memset(buffer + read_count, 0, PAGE_SIZE - read_count);
+  if (buffer != page_data)
+    memcpy(page_data, buffer, PAGE_SIZE);
+  return true;
+}
+
+bool DiskManager::DirectWrite(page_id_t page_id, const char *page_data) {
+  const char *buffer = page_data;
+  if (reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0) {
+    memcpy(bounce_, page_data, PAGE_SIZE);
+    buffer = bounce_;
+  }
+  if (pwrite(db_fd_, buffer, PAGE_SIZE,
+             static_cast<off_t>(page_id) * PAGE_SIZE) < 0) {
+    if (errno == EINVAL) {
+      LOG_DEBUG("O_DIRECT rejected, falling back to buffered I/O");
+      DisableDirectIO();
+      return false;
+    }
+    LOG_DEBUG("I/O error while writing");
+  }
+  return true;
+}
+
+bool DiskManager::WriteRun(const page_id_t *page_ids,
+                           const char *const *page_data, int count) {
+  std::vector<struct iovec> iov(count);
+  for (int i = 0; i < count; ++i) {
+    // an unaligned buffer needs the bounce buffer, page by page
+    if (IsDirectIO() &&
+        reinterpret_cast<uintptr_t>(page_data[i]) % DIRECT_IO_ALIGNMENT != 0) {
+      for (int j = 0; j < count; ++j)
+        if (!DirectWrite(page_ids[j], page_data[j]))
+          return false;
+      return true;
+    }
+    iov[i].iov_base = const_cast<char *>(page_data[i]);
+    iov[i].iov_len = PAGE_SIZE;
+  }
+  off_t offset = static_cast<off_t>(page_ids[0]) * PAGE_SIZE;
+  size_t total = static_cast<size_t>(count) * PAGE_SIZE, done = 0;
+  // go on after a short write, from where it stopped
+  while (done < total) {
+    int first = done / PAGE_SIZE;
+    iov[first].iov_base =
+        const_cast<char *>(page_data[first]) + done % PAGE_SIZE;
+    iov[first].iov_len = PAGE_SIZE - done % PAGE_SIZE;
+    ssize_t written =
+        pwritev(db_fd_, &iov[first], count - first, offset + done);
+    if (written < 0) {
+      if (errno == EINVAL && IsDirectIO()) {
+        LOG_DEBUG("O_DIRECT rejected, falling back to buffered I/O");
+        DisableDirectIO();
+        return false;
+      }
+      LOG_DEBUG("I/O error while writing");
+      break;
+    }
+    done += written;
+  }
+  return true;
+}
+
+void DiskManager::DisableDirectIO() {
+  close(db_fd_);
+  db_fd_ = open(file_name_.c_str(), O_RDWR);
+  direct_io_ = false;
+}
+
 /**
  * Private helper function to get disk file size
  */
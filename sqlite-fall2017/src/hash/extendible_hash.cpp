@@ -1,5 +1,10 @@
 #include <list>
+#include <new>
 #include <string.h>
+#include <thread>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #include "hash/extendible_hash.h"
 #include "page/page.h"
@@ -33,39 +38,233 @@ void WfirstRWLock::release_write(){
   }
   inwriteflag = false;
 }
+
+static inline size_t AlignUp(size_t n, size_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+/*
+ * bit i of the result is set when fingerprints[i] == fingerprint, for the
+ * FINGERPRINT_GROUP bytes at fingerprints
+ */
+static inline uint32_t MatchGroup(const uint8_t *fingerprints,
+                                  uint8_t fingerprint) {
+#if defined(__AVX2__)
+  __m256i group =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fingerprints));
+  return _mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(group, _mm256_set1_epi8(fingerprint)));
+#elif defined(__SSE2__)
+  __m128i group =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints));
+  return _mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8(fingerprint)));
+#else
+  uint32_t match = 0;
+  for(int i = 0; i != FINGERPRINT_GROUP; i++)
+    if(fingerprints[i] == fingerprint)
+      match |= 1u << i;
+  return match;
+#endif
+}
+
 /*
  * constructor
  * array_size: fixed array size for each bucket
+ * merge_fill: buddy buckets holding at most merge_fill * size entries
+ * together are merged, 0 to never merge
  */
 template <typename K, typename V>
-ExtendibleHash<K, V>::ExtendibleHash(size_t size): bucket_size(size){
+ExtendibleHash<K, V>::ExtendibleHash(size_t size, double merge_fill)
+    : bucket_size(size), merge_limit(merge_fill * size){
+  fingerprint_groups = (bucket_size + FINGERPRINT_GROUP - 1) / FINGERPRINT_GROUP;
+  keys_offset = AlignUp(sizeof(struct bucket) +
+                        fingerprint_groups * FINGERPRINT_GROUP, alignof(K));
+  vals_offset = AlignUp(keys_offset + sizeof(K) * bucket_size, alignof(V));
+  bucket_bytes = AlignUp(vals_offset + sizeof(V) * bucket_size,
+                         CACHE_LINE_SIZE);
   global_depth = 1;
-  depth_mask = 1;
-  directory = new struct bucket*[2]();
-  directory[0] = new bucket { 0, 
-                              1,
-                              new WfirstRWLock(),
-                              new bool[bucket_size](), 
-                              new K[bucket_size](), 
-                              new V[bucket_size]()
-                            };
-  directory[1] = new bucket { 1, 
-                              1,
-                              new WfirstRWLock(),
-                              new bool[bucket_size](), 
-                              new K[bucket_size](), 
-                              new V[bucket_size]()
-                            };
+  struct dir* d = NewDir(1);
+  d->buckets[0] = NewBucket(0, 1);
+  d->buckets[1] = NewBucket(1, 1);
+  directory = d;
+  deepest_buckets = 2;
   bucket_num = 2;
+  next_bucket_id = 2;
   global_lk = new WfirstRWLock();
-  mask_lk = new WfirstRWLock();
 }
 
 /*
- * helper function to calculate the hashing address of input key
+ * Every thread counts its optimistic reads in one reader shard, round robin
+ * over READER_SHARDS. The index is shared by all the tables
  */
+static inline unsigned ReaderShard() {
+  static std::atomic<unsigned> next_shard(0);
+  thread_local unsigned shard = next_shard++ % READER_SHARDS;
+  return shard;
+}
+
 template <typename K, typename V>
-size_t ExtendibleHash<K, V>::HashKey(const K &key) {
+struct ExtendibleHash<K, V>::dir* ExtendibleHash<K, V>::NewDir(int depth) {
+  size_t size = size_t(1) << depth;
+  return new dir { size - 1, new std::atomic<struct bucket*>[size]() };
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::DeleteDir(struct dir* d) {
+  delete[] d->buckets;
+  delete d;
+}
+
+/*
+ * Called holding global_lk in write mode, after the retired objects were
+ * unpublished. A reader shard seen empty after that holds no reader that
+ * could have picked them up: the objects retired since the last call become
+ * a batch waiting for every shard, and each shard empty now is crossed off
+ * every batch. A batch left with no shard is freed, the others stay for the
+ * next call
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::ReclaimRetired() {
+  // the unpublishing stores are release only: keep them before the shard
+  // loads below, pairs with the seq_cst increment of Find
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if(!retired_buckets.empty() || !retired_dirs.empty()){
+    retired_batch batch;
+    batch.busy_shards = READER_SHARDS == 64 ? ~uint64_t(0)
+                                            : (uint64_t(1) << READER_SHARDS) - 1;
+    batch.buckets.swap(retired_buckets);
+    batch.dirs.swap(retired_dirs);
+    retired_batches.push_back(std::move(batch));
+  }
+  if(retired_batches.empty())
+    return;
+  uint64_t empty_shards = 0;
+  for(unsigned i = 0; i < READER_SHARDS; i++)
+    if(reader_shards[i].readers.load() == 0)
+      empty_shards |= uint64_t(1) << i;
+  size_t kept = 0;
+  for(retired_batch &batch : retired_batches){
+    batch.busy_shards &= ~empty_shards;
+    if(batch.busy_shards != 0){
+      if(&retired_batches[kept] != &batch)
+        std::swap(retired_batches[kept], batch);
+      kept++;
+      continue;
+    }
+    for(struct bucket* p : batch.buckets)
+      DeleteBucket(p);
+    for(struct dir* d : batch.dirs)
+      DeleteDir(d);
+  }
+  retired_batches.resize(kept);
+}
+
+template <typename K, typename V>
+size_t ExtendibleHash<K, V>::GetRetiredCount() {
+  unique_readguard<WfirstRWLock> lock(*global_lk);
+  size_t count = retired_buckets.size() + retired_dirs.size();
+  for(retired_batch &batch : retired_batches)
+    count += batch.buckets.size() + batch.dirs.size();
+  return count;
+}
+
+/*
+ * allocate a bucket block, with all the slots empty
+ */
+template <typename K, typename V>
+struct ExtendibleHash<K, V>::bucket*
+ExtendibleHash<K, V>::NewBucket(int bucket_id, int local_depth) {
+  void *block = nullptr;
+  if(posix_memalign(&block, CACHE_LINE_SIZE, bucket_bytes) != 0)
+    throw std::bad_alloc();
+  char *bytes = static_cast<char *>(block);
+  struct bucket* p = new (block) bucket { bucket_id,
+                                          local_depth,
+                                          {0},
+                                          new WfirstRWLock(),
+                                          reinterpret_cast<uint8_t *>(
+                                              bytes + sizeof(struct bucket)),
+                                          reinterpret_cast<K *>(
+                                              bytes + keys_offset),
+                                          reinterpret_cast<V *>(
+                                              bytes + vals_offset)
+                                        };
+  memset(p->fingerprints, 0, fingerprint_groups * FINGERPRINT_GROUP);
+  for(size_t offset = 0; offset != bucket_size; offset++){
+    new (&p->keys_array[offset]) K();
+    new (&p->val_array[offset]) V();
+  }
+  return p;
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::DeleteBucket(struct bucket* p) {
+  for(size_t offset = 0; offset != bucket_size; offset++){
+    p->keys_array[offset].~K();
+    p->val_array[offset].~V();
+  }
+  delete p->local_lk;
+  p->~bucket();
+  free(p);
+}
+
+/*
+ * one byte of the key hash, from other bits than the directory uses. 0 marks
+ * an empty slot, so it is never a fingerprint
+ */
+template <typename K, typename V>
+uint8_t ExtendibleHash<K, V>::Fingerprint(long long unsigned hash) const {
+  uint8_t fingerprint = (hash * 0x9E3779B97F4A7C15ull) >> 56;
+  return fingerprint == 0 ? 1 : fingerprint;
+}
+
+template <typename K, typename V>
+int ExtendibleHash<K, V>::FindSlot(struct bucket* p, const K &key,
+                                   uint8_t fingerprint) const {
+  for(size_t group = 0; group != fingerprint_groups; group++){
+    uint32_t match =
+        MatchGroup(p->fingerprints + group * FINGERPRINT_GROUP, fingerprint);
+    while(match != 0){
+      size_t offset = group * FINGERPRINT_GROUP + __builtin_ctz(match);
+      if(p->keys_array[offset] == key)
+        return offset;
+      match &= match - 1;
+    }
+  }
+  return -1;
+}
+
+template <typename K, typename V>
+int ExtendibleHash<K, V>::FindEmptySlot(struct bucket* p) const {
+  for(size_t group = 0; group != fingerprint_groups; group++){
+    uint32_t match = MatchGroup(p->fingerprints + group * FINGERPRINT_GROUP, 0);
+    if(match != 0){
+      // the padding of the last group is empty too
+      size_t offset = group * FINGERPRINT_GROUP + __builtin_ctz(match);
+      return offset < bucket_size ? offset : -1;
+    }
+  }
+  return -1;
+}
+
+/*
+ * the padding of the last fingerprint group counts as empty slots
+ */
+template <typename K, typename V>
+size_t ExtendibleHash<K, V>::CountEntries(struct bucket* p) const {
+  size_t empty = 0;
+  for(size_t group = 0; group != fingerprint_groups; group++)
+    empty += __builtin_popcount(
+        MatchGroup(p->fingerprints + group * FINGERPRINT_GROUP, 0));
+  return fingerprint_groups * FINGERPRINT_GROUP - empty;
+}
+
+/*
+ * helper function to calculate the full hash of input key
+ */
+template <typename K, typename V>
+long long unsigned ExtendibleHash<K, V>::Hash(const K &key) {
   /*
   K temp_key = key;
   long long unsigned bitstring = 0;
@@ -76,14 +275,24 @@ size_t ExtendibleHash<K, V>::HashKey(const K &key) {
   size_t bitstring;
   if(typeid(key) == typeid(RID)){
     K key_copy = key, *key_p = &key_copy;
-    bitstring = std::hash<int64_t>{}(reinterpret_cast<RID *>(key_p)->Get());
+    // the page id is in the high half, fold it into the low bits the
+    // directory is indexed by, or rids of one slot number never split apart
+    int64_t rid = reinterpret_cast<RID *>(key_p)->Get();
+    bitstring = std::hash<int64_t>{}(rid ^ (rid >> 32));
   }
   else
     bitstring = std::hash<K>{}(key);
-  bitstring &= depth_mask;
   return bitstring;
 }
 
+/*
+ * helper function to calculate the hashing address of input key
+ */
+template <typename K, typename V>
+size_t ExtendibleHash<K, V>::HashKey(const K &key) {
+  return Hash(key) & directory.load()->depth_mask;
+}
+
 /*
  * helper function to return global depth of hash table
  * NOTE: you must implement this function in order to pass test
@@ -101,10 +310,11 @@ int ExtendibleHash<K, V>::GetGlobalDepth() const {
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
   unique_readguard<WfirstRWLock> lock(*global_lk);
-  size_t max_subscript = pow(2, global_depth);
-  for(size_t offset = 0; offset != max_subscript; offset++){
-    if(directory[offset]->bucket_id == bucket_id)
-      return directory[offset]->local_depth;
+  struct dir* d = directory.load();
+  for(size_t offset = 0; offset <= d->depth_mask; offset++){
+    struct bucket* p = d->buckets[offset].load();
+    if(p->bucket_id == bucket_id)
+      return p->local_depth;
   }
   return -1;
 }
@@ -120,37 +330,136 @@ int ExtendibleHash<K, V>::GetNumBuckets() const {
 
 /*
  * lookup function to find value associate with input key
+ * Optimistic when K and V can be read while they change: take the version
+ * of the bucket, probe it, and keep the result only if the version is still
+ * the same. The reader shard keeps the bucket and directory read alive
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
+  long long unsigned hash = Hash(key);
+  if(!optimistic)
+    return LockedFind(hash, key, value);
+  uint8_t fingerprint = Fingerprint(hash);
+  std::atomic<size_t> &readers = reader_shards[ReaderShard()].readers;
+  // seq_cst, like the directory and bucket loads below: pairs with the fence
+  // of ReclaimRetired() between unpublishing and the shard loads, so either a
+  // reclaim sees this reader or the reader sees the new pointers
+  readers.fetch_add(1);
+  for(int attempt = 0; attempt != OPTIMISTIC_RETRIES; attempt++){
+    struct dir* d = directory.load();
+    struct bucket* p = d->buckets[hash & d->depth_mask].load();
+    uint64_t version = p->version.load(std::memory_order_acquire);
+    if(version & 1)
+      continue;
+    int offset = FindSlot(p, key, fingerprint);
+    V result = V();
+    if(offset >= 0)
+      result = p->val_array[offset];
+    // keep the reads of the bucket before the second version load
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(p->version.load(std::memory_order_relaxed) != version)
+      continue;
+    readers.fetch_sub(1, std::memory_order_release);
+    if(offset < 0)
+      return false;
+    value = result;
+    return true;
+  }
+  readers.fetch_sub(1, std::memory_order_release);
+  return LockedFind(hash, key, value);
+}
+
+template <typename K, typename V>
+bool ExtendibleHash<K, V>::LockedFind(long long unsigned hash, const K &key,
+                                      V &value) {
   unique_readguard<WfirstRWLock> lock(*global_lk);
-  struct bucket* p = directory[HashKey(key)];
+  struct dir* d = directory.load();
+  struct bucket* p = d->buckets[hash & d->depth_mask].load();
   unique_readguard<WfirstRWLock> llock(*(p->local_lk));
-  for(size_t offset = 0; offset != bucket_size; offset++){
-    if(p->occupied_flag_array[offset] && p->keys_array[offset] == key){
-      value = p->val_array[offset];
-      return true;
-    }
-  }
-  return false;
+  int offset = FindSlot(p, key, Fingerprint(hash));
+  if(offset < 0)
+    return false;
+  value = p->val_array[offset];
+  return true;
 }
 
 /*
  * delete <key,value> entry in hash table
- * Shrink & Combination is not required for this project
+ * A bucket left with few entries is merged, see Merge()
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Remove(const K &key) {
-  unique_readguard<WfirstRWLock> lock(*global_lk);
-  struct bucket* p = directory[HashKey(key)];
-  unique_writeguard<WfirstRWLock> llock(*(p->local_lk));
-  for(size_t offset = 0; offset != bucket_size; offset++){
-    if(p->occupied_flag_array[offset] && p->keys_array[offset] == key){
-      p->occupied_flag_array[offset] = false;
-      return true;
-    }
+  long long unsigned hash = Hash(key);
+  bool underflow;
+  {
+    unique_readguard<WfirstRWLock> lock(*global_lk);
+    struct dir* d = directory.load();
+    struct bucket* p = d->buckets[hash & d->depth_mask].load();
+    unique_writeguard<WfirstRWLock> llock(*(p->local_lk));
+    int offset = FindSlot(p, key, Fingerprint(hash));
+    if(offset < 0)
+      return false;
+    BeginWrite(p);
+    p->fingerprints[offset] = 0;
+    EndWrite(p);
+    underflow = merge_limit > 0 && p->local_depth > 1 &&
+                CountEntries(p) <= merge_limit;
+  }
+  if(underflow)
+    Merge(hash);
+  return true;
+}
+
+/*
+ * Undo splits: the bucket of hash and its buddy, which differs in bit
+ * local_depth - 1 only, are copied into one new bucket, published in all the
+ * slots of both, and retired, as a split does. Then, as long as no bucket has
+ * the global depth, the directory is halved, keeping the lower half
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Merge(long long unsigned hash) {
+  unique_writeguard<WfirstRWLock> lock(*global_lk);
+  struct dir* d = directory.load();
+  struct bucket* p = d->buckets[hash & d->depth_mask].load();
+  while(p->local_depth > 1){
+    size_t buddy_bit = size_t(1) << (p->local_depth - 1);
+    struct bucket* buddy =
+        d->buckets[(hash & d->depth_mask) ^ buddy_bit].load();
+    if(buddy->local_depth != p->local_depth ||
+       CountEntries(p) + CountEntries(buddy) > merge_limit)
+      break;
+    struct bucket* low = hash & buddy_bit ? buddy : p;
+    struct bucket* high = hash & buddy_bit ? p : buddy;
+    struct bucket* merged = NewBucket(low->bucket_id, p->local_depth - 1);
+    for(struct bucket* q : {low, high})
+      for(size_t offset = 0; offset < bucket_size; offset++)
+        if(q->fingerprints[offset] != 0)
+          SafeInsert(merged, q->keys_array[offset], q->val_array[offset]);
+    for(size_t i = hash & (buddy_bit - 1); i <= d->depth_mask; i += buddy_bit)
+      d->buckets[i].store(merged, std::memory_order_release);
+    if(p->local_depth == global_depth)
+      deepest_buckets -= 2;
+    BeginWrite(low);
+    BeginWrite(high);
+    retired_buckets.push_back(low);
+    retired_buckets.push_back(high);
+    bucket_num--;
+    p = merged;
+  }
+  while(global_depth > 1 && deepest_buckets == 0){
+    struct dir* old_d = d;
+    d = NewDir(global_depth - 1);
+    for(size_t i = 0; i <= d->depth_mask; i++)
+      d->buckets[i] = old_d->buckets[i].load();
+    directory.store(d);
+    retired_dirs.push_back(old_d);
+    global_depth--;
+    // a bucket of the global depth has a single slot
+    for(size_t i = 0; i <= d->depth_mask; i++)
+      if(d->buckets[i].load()->local_depth == global_depth)
+        deepest_buckets++;
   }
-  return false;
+  ReclaimRetired();
 }
 /*
  * insert <key,value> entry in hash table
@@ -159,28 +468,29 @@ bool ExtendibleHash<K, V>::Remove(const K &key) {
  */
 template <typename K, typename V>
 void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
+  long long unsigned hash = Hash(key);
+  uint8_t fingerprint = Fingerprint(hash);
   global_lk->lock_read();
-  struct bucket* p = directory[HashKey(key)];
+  struct dir* d = directory.load();
+  struct bucket* p = d->buckets[hash & d->depth_mask].load();
   p->local_lk->lock_write();
   // insert directly if the key or an empty slot is found
-  size_t first_empty_offset;
-  bool empty_slot_found = false;
-  for(size_t offset = 0; offset != bucket_size; offset++){
-    if(!empty_slot_found && !p->occupied_flag_array[offset]){
-      first_empty_offset = offset;
-      empty_slot_found = true;
-    }
-    if(p->occupied_flag_array[offset] && p->keys_array[offset] == key){
-      p->val_array[offset] = value;
-      p->local_lk->release_write();
-      global_lk->release_read();
-      return;
-    }
+  int offset = FindSlot(p, key, fingerprint);
+  if(offset >= 0){
+    BeginWrite(p);
+    p->val_array[offset] = value;
+    EndWrite(p);
+    p->local_lk->release_write();
+    global_lk->release_read();
+    return;
   }
-  if(empty_slot_found){
-    p->keys_array[first_empty_offset] = key;
-    p->val_array[first_empty_offset] = value;
-    p->occupied_flag_array[first_empty_offset] = true;
+  offset = FindEmptySlot(p);
+  if(offset >= 0){
+    BeginWrite(p);
+    p->keys_array[offset] = key;
+    p->val_array[offset] = value;
+    p->fingerprints[offset] = fingerprint;
+    EndWrite(p);
     p->local_lk->release_write();
     global_lk->release_read();
     return;
@@ -189,121 +499,128 @@ void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
   // increase global depth
   global_lk->release_read();
   global_lk->lock_write();
+  // another insert may have split the bucket meanwhile
+  d = directory.load();
+  if(d->buckets[hash & d->depth_mask].load() != p){
+    global_lk->release_write();
+    Insert(key, value);
+    return;
+  }
   if(p->local_depth == global_depth){
     assert(global_depth != max_global_depth);
-    struct bucket** old_directory = directory;
-    size_t directory_size = pow(2, global_depth);
-    directory = new struct bucket*[directory_size * 2]();
-    memcpy(directory, old_directory, sizeof(struct bucket*) * directory_size);
-    memcpy(directory + directory_size, old_directory, sizeof(struct bucket*) * directory_size);
-    delete[] old_directory;
+    struct dir* old_d = d;
+    size_t directory_size = old_d->depth_mask + 1;
+    d = NewDir(global_depth + 1);
+    for(size_t i = 0; i != directory_size; i++){
+      d->buckets[i] = old_d->buckets[i].load();
+      d->buckets[i + directory_size] = old_d->buckets[i].load();
+    }
+    directory.store(d);
+    retired_dirs.push_back(old_d);
     global_depth++;
-    mask_lk->lock_write();
-    depth_mask = (depth_mask << 1) + 1;
-    mask_lk->release_write();
+    deepest_buckets = 0;
   }
-  // Split
-  struct bucket* new_bucket0 = new bucket { p->bucket_id, 
-                                            p->local_depth + 1,
-                                            new WfirstRWLock(),
-                                            new bool[bucket_size](), 
-                                            new K[bucket_size](), 
-                                            new V[bucket_size]()
-                                          };
-  struct bucket* new_bucket1 = new bucket { bucket_num++, 
-                                            p->local_depth + 1,
-                                            new WfirstRWLock(), 
-                                            new bool[bucket_size](), 
-                                            new K[bucket_size](), 
-                                            new V[bucket_size]()
-                                          };
-  size_t max_subscript = pow(2, global_depth);
+  // Split: fill the new buckets before readers can see them
+  struct bucket* new_bucket0 = NewBucket(p->bucket_id, p->local_depth + 1);
+  struct bucket* new_bucket1 = NewBucket(next_bucket_id++, p->local_depth + 1);
+  bucket_num++;
+  if(p->local_depth + 1 == global_depth)
+    deepest_buckets += 2;
+  size_t split_bit = size_t(1) << p->local_depth;
+  for(size_t offset = 0; offset < bucket_size; offset++){
+    if(p->fingerprints[offset] != 0)
+      SafeInsert(Hash(p->keys_array[offset]) & split_bit ? new_bucket1
+                                                          : new_bucket0,
+                 p->keys_array[offset], p->val_array[offset]);
+  }
+  size_t max_subscript = d->depth_mask + 1;
   size_t i;
-  size_t step = pow(2, p->local_depth);
+  size_t step = split_bit;
   for(i = 0; i != max_subscript; i++)
-    if(directory[i] == p)
+    if(d->buckets[i].load() == p)
       break;
   for(size_t j = 0 ; i < max_subscript; i += step, j++){
     if (j % 2 == 0)
-      directory[i] = new_bucket0;
+      d->buckets[i].store(new_bucket0, std::memory_order_release);
     else
-      directory[i] = new_bucket1;
+      d->buckets[i].store(new_bucket1, std::memory_order_release);
   }
-  // redistribute
-  for(size_t offset = 0; offset < bucket_size; offset++){
-    SafeInsert(p->keys_array[offset], p->val_array[offset]);
-  }
-  delete[] p->occupied_flag_array;
-  delete[] p->keys_array;
-  delete[] p->val_array;
-  delete p->local_lk;
-  delete p;
+  // a reader still holding p fails to validate from now on
+  BeginWrite(p);
+  retired_buckets.push_back(p);
+  ReclaimRetired();
   // Try to insert again;
   global_lk->release_write();
   Insert(key, value);
   //debug(1);
 }
-// helper function SafeInsert used in Insert for DRY
+// helper function SafeInsert used in Insert for DRY, p is not published
 template <typename K, typename V>
-bool ExtendibleHash<K, V>::SafeInsert(const K &key, const V &value){
-  struct bucket* p = directory[HashKey(key)];
+bool ExtendibleHash<K, V>::SafeInsert(struct bucket* p, const K &key,
+                                      const V &value){
+  long long unsigned hash = Hash(key);
   /*
   std::cout << "@@SafeInsert:  " << "key: " << key
             << "HashKey: " << HashKey(key) 
             << "bucket_id" << p->bucket_id << std::endl;
   */
-  for(size_t offset = 0; offset != bucket_size; offset++){
-    if(!p->occupied_flag_array[offset]){
-      p->keys_array[offset] = key;
-      p->val_array[offset] = value;
-      p->occupied_flag_array[offset] = true;
-      return true;
-    }
-  }
-  return false;
+  int offset = FindEmptySlot(p);
+  if(offset < 0)
+    return false;
+  p->keys_array[offset] = key;
+  p->val_array[offset] = value;
+  p->fingerprints[offset] = Fingerprint(hash);
+  return true;
 }
 // destructor
 template <typename K, typename V>
 ExtendibleHash<K, V>::~ExtendibleHash(){
   struct bucket* p;
-  size_t max_subscript = pow(2, global_depth);
+  struct dir* d = directory.load();
+  size_t max_subscript = d->depth_mask + 1;
   for(size_t i = 0; i != max_subscript; i++){
-    if(directory[i] != nullptr){
-      p = directory[i];
+    if(d->buckets[i].load() != nullptr){
+      p = d->buckets[i].load();
       size_t step = pow(2, p->local_depth);
       for(size_t j = i; j < max_subscript; j += step)
-        directory[j] = nullptr;
-      delete[] p->occupied_flag_array;
-      delete[] p->keys_array;
-      delete[] p->val_array;
-      delete p->local_lk;
-      delete p;
+        d->buckets[j] = nullptr;
+      DeleteBucket(p);
     }
   }
-  delete[] directory;
+  DeleteDir(d);
+  for(struct bucket* p : retired_buckets)
+    DeleteBucket(p);
+  for(struct dir* d : retired_dirs)
+    DeleteDir(d);
+  for(retired_batch &batch : retired_batches){
+    for(struct bucket* p : batch.buckets)
+      DeleteBucket(p);
+    for(struct dir* d : batch.dirs)
+      DeleteDir(d);
+  }
   delete global_lk;
-  delete mask_lk;
 }
 // help function debug: mode 0 for brief info; mode 1 for detail.
 template <typename K, typename V>
 void ExtendibleHash<K, V>:: debug(int mode){
   unique_readguard<WfirstRWLock> lock(*global_lk);
+  struct dir* d = directory.load();
   std::cout << "Debug:############################" << std::endl
             << "  global_depth: " << global_depth
-            << "  depth_mask" << depth_mask
+            << "  depth_mask" << d->depth_mask
             << "  bucket_num: "   << bucket_num << std::endl;
   if(mode == 1){
     size_t max_subscript = pow(2, global_depth);
     std::cout << "directory:############################" << std::endl;
     for(size_t i = 0; i != max_subscript; i++){
-      struct bucket* p = directory[i];
+      struct bucket* p = d->buckets[i].load();
       std::cout << "  subscript:  " << i
                 << "  bucket_id: " << p->bucket_id
                 << "  local_depth: " << p->local_depth << std::endl
                 << "  bucket_info:##########################" << std::endl;
       for(size_t j = 0; j != bucket_size; j++){
         std::cout << "    offset: " << j
-                  << "  occupied?: " << p->occupied_flag_array[j]
+                  << "  occupied?: " << (p->fingerprints[j] != 0)
                   << "  key: " << p->keys_array[j]
                   << std::endl;
       }
@@ -0,0 +1,182 @@
+#include <list>
+#include <string>
+
+#include "concurrency/lock_manager.h"
+#include "hash/linear_hash.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+// segment of bucket index, and the first index of that segment
+static inline size_t SegmentOf(size_t index) {
+  return index < 2 ? 0 : 63 - __builtin_clzll(index);
+}
+static inline size_t SegmentStart(size_t segment) {
+  return segment == 0 ? 0 : size_t(1) << segment;
+}
+
+/*
+ * constructor
+ * size: a bucket is split once the table holds more than size entries per
+ * bucket on average
+ */
+template <typename K, typename V>
+LinearHash<K, V>::LinearHash(size_t size)
+    : bucket_size_(size), num_buckets_(2), size_(0) {
+  for(size_t i = 0; i < LINEAR_HASH_SEGMENTS; i++)
+    segments_[i] = nullptr;
+  std::atomic<bucket *> *segment = new std::atomic<bucket *>[2];
+  segment[0] = new bucket;
+  segment[1] = new bucket;
+  segments_[0] = segment;
+}
+
+template <typename K, typename V>
+LinearHash<K, V>::~LinearHash() {
+  size_t num_buckets = num_buckets_.load();
+  for(size_t i = 0; i < num_buckets; i++)
+    delete GetBucket(i);
+  for(size_t i = 0; i < LINEAR_HASH_SEGMENTS; i++)
+    delete[] segments_[i].load();
+}
+
+/*
+ * the hash of keys with the high bits mixed into the low ones, which pick the
+ * bucket (std::hash of an integer or a RID is the value itself)
+ */
+template <typename K, typename V>
+uint64_t LinearHash<K, V>::Hash(const K &key) const {
+  uint64_t hash = std::hash<K>{}(key) * 0x9E3779B97F4A7C15ull;
+  return hash ^ (hash >> 32);
+}
+
+template <typename K, typename V>
+size_t LinearHash<K, V>::Address(uint64_t hash, size_t num_buckets) {
+  size_t level_size = size_t(1) << (63 - __builtin_clzll(num_buckets));
+  size_t index = hash & (level_size - 1);
+  // already split in this round
+  if(index < num_buckets - level_size)
+    index = hash & (2 * level_size - 1);
+  return index;
+}
+
+template <typename K, typename V>
+typename LinearHash<K, V>::bucket *LinearHash<K, V>::GetBucket(
+    size_t index) const {
+  size_t segment = SegmentOf(index);
+  return segments_[segment].load(std::memory_order_acquire)
+      [index - SegmentStart(segment)].load(std::memory_order_acquire);
+}
+
+/*
+ * Only a split of the bucket moves keys out of it, and the split needs the
+ * bucket latch, so the key stays in the bucket found here as long as it is
+ * locked. Retry when a split got in before the lock
+ */
+template <typename K, typename V>
+typename LinearHash<K, V>::bucket *LinearHash<K, V>::LockBucket(
+    uint64_t hash) {
+  while(true){
+    size_t index = Address(hash, num_buckets_.load(std::memory_order_acquire));
+    bucket *b = GetBucket(index);
+    b->latch.lock();
+    if(Address(hash, num_buckets_.load(std::memory_order_acquire)) == index)
+      return b;
+    b->latch.unlock();
+  }
+}
+
+template <typename K, typename V>
+bool LinearHash<K, V>::Find(const K &key, V &value) {
+  bucket *b = LockBucket(Hash(key));
+  std::lock_guard<std::mutex> lock(b->latch, std::adopt_lock);
+  for(auto &entry : b->entries){
+    if(entry.first == key){
+      value = entry.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename K, typename V>
+bool LinearHash<K, V>::Remove(const K &key) {
+  bucket *b = LockBucket(Hash(key));
+  std::lock_guard<std::mutex> lock(b->latch, std::adopt_lock);
+  for(auto &entry : b->entries){
+    if(entry.first == key){
+      entry = std::move(b->entries.back());
+      b->entries.pop_back();
+      size_--;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * insert <key,value> entry in hash table, or update the value of key. At most
+ * one bucket is split per insert
+ */
+template <typename K, typename V>
+void LinearHash<K, V>::Insert(const K &key, const V &value) {
+  {
+    bucket *b = LockBucket(Hash(key));
+    std::lock_guard<std::mutex> lock(b->latch, std::adopt_lock);
+    for(auto &entry : b->entries){
+      if(entry.first == key){
+        entry.second = value;
+        return;
+      }
+    }
+    b->entries.emplace_back(key, value);
+  }
+  if(++size_ > bucket_size_ * num_buckets_.load())
+    Split();
+}
+
+/*
+ * split the bucket at the split pointer into itself and bucket num_buckets,
+ * which gets the keys with the level bit set
+ */
+template <typename K, typename V>
+void LinearHash<K, V>::Split() {
+  std::unique_lock<std::mutex> split_lock(split_latch_, std::try_to_lock);
+  if(!split_lock.owns_lock())
+    return;
+  size_t num_buckets = num_buckets_.load();
+  if(size_.load() <= bucket_size_ * num_buckets)
+    return;
+  size_t level_size = size_t(1) << (63 - __builtin_clzll(num_buckets));
+  size_t segment = SegmentOf(num_buckets);
+  if(segments_[segment].load() == nullptr){
+    if(segment >= LINEAR_HASH_SEGMENTS - 1)
+      return;
+    // the first bucket of a new level, its segment holds the whole level
+    segments_[segment].store(new std::atomic<bucket *>[level_size],
+                             std::memory_order_release);
+  }
+  bucket *old_bucket = GetBucket(num_buckets - level_size);
+  bucket *new_bucket = new bucket;
+  std::lock_guard<std::mutex> lock(old_bucket->latch);
+  auto &entries = old_bucket->entries;
+  for(size_t i = 0; i < entries.size();){
+    if(Hash(entries[i].first) & level_size){
+      new_bucket->entries.push_back(std::move(entries[i]));
+      entries[i] = std::move(entries.back());
+      entries.pop_back();
+    } else {
+      i++;
+    }
+  }
+  segments_[segment].load()[num_buckets - SegmentStart(segment)].store(
+      new_bucket, std::memory_order_release);
+  num_buckets_.store(num_buckets + 1, std::memory_order_release);
+}
+
+template class LinearHash<page_id_t, Page *>;
+template class LinearHash<RID, LockManager::TxnList *>;
+// test purpose
+template class LinearHash<int, std::string>;
+template class LinearHash<int, int>;
+} // namespace cmudb
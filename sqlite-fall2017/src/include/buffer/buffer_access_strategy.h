@@ -0,0 +1,40 @@
+/**
+ * buffer_access_strategy.h
+ *
+ * Functionality: A caller doing a bulk read (sequential scan of a table heap)
+ * passes an access strategy to BufferPoolManager::FetchPage. Pages missed by
+ * the scan are loaded into a small private ring of frames which the scan keeps
+ * recycling, instead of taking a frame from the replacer for every page and
+ * evicting the shared hot pages of concurrent point queries.
+ *
+ * A strategy object belongs to one scan and is not thread safe.
+ */
+
+#pragma once
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class Page;
+
+class BufferAccessStrategy {
+  friend class BufferPoolManagerInstance;
+
+public:
+  BufferAccessStrategy(size_t ring_size = RING_BUFFER_SIZE)
+      : ring_(ring_size, nullptr), ring_page_ids_(ring_size, INVALID_PAGE_ID),
+        current_(0) {}
+
+  inline size_t GetRingSize() const { return ring_.size(); }
+
+private:
+  // frames owned by this ring and the page the ring loaded into each of them;
+  // a frame is only recycled while it still holds that page
+  std::vector<Page *> ring_;
+  std::vector<page_id_t> ring_page_ids_;
+  size_t current_;
+};
+
+} // namespace cmudb
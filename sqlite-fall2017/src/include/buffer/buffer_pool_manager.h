@@ -4,45 +4,121 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ *
+ * Two implementations: BufferPoolManagerInstance, a single pool under one
+ * latch, and ParallelBufferPoolManager, several instances a page is routed to
+ * by its id. Page ids are allocated by the disk manager in both.
  */
 
 #pragma once
-#include <list>
-#include <mutex>
+#include <string>
 
-#include "buffer/lru_replacer.h"
-#include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
-#include "logging/log_manager.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_metrics.h"
+#include "buffer/page_guard.h"
 #include "page/page.h"
 
 namespace cmudb {
 class BufferPoolManager {
 public:
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                          LogManager *log_manager = nullptr);
+  virtual ~BufferPoolManager() {}
+
+  // strategy: optional ring of frames for bulk reads, see
+  // buffer_access_strategy.h
+  // page_class: eviction class hint, a resident page keeps the highest class
+  // it was fetched with (or set to, see Page::SetPageClass)
+  virtual Page *FetchPage(page_id_t page_id,
+                          BufferAccessStrategy *strategy = nullptr,
+                          PageClass page_class = PageClass::DATA) = 0;
+
+  // pin page_id only if it is resident and not being read, never waits.
+  // nullptr otherwise
+  virtual Page *FetchPageIfResident(page_id_t page_id) = 0;
+
+  // fetch count pages at once: pages[i] is page_ids[i], or nullptr when no
+  // frame was left for it. Returns the number of pages fetched
+  virtual size_t FetchPages(const page_id_t *page_ids, size_t count,
+                            Page **pages) = 0;
+
+  // fetch child_id, a child of parent, which the caller has pinned. A child
+  // fetched before through the same parent and still resident is pinned
+  // through parent's swizzled frame pointer, without the page table lookup
+  // or the buffer pool latch
+  virtual Page *FetchChild(Page *parent, page_id_t child_id) = 0;
+
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty) = 0;
+
+  // unpin a frame the caller holds, without the page table lookup
+  virtual bool UnpinPage(Page *page, bool is_dirty) = 0;
+
+  // FetchPage/NewPage returning a guard that unpins the page (and drops the
+  // latch taken here) when it goes out of scope, see page_guard.h
+  PageGuard FetchPageGuarded(page_id_t page_id,
+                             BufferAccessStrategy *strategy = nullptr,
+                             PageClass page_class = PageClass::DATA);
+  ReadPageGuard FetchPageRead(page_id_t page_id,
+                              BufferAccessStrategy *strategy = nullptr);
+  WritePageGuard FetchPageWrite(page_id_t page_id,
+                                BufferAccessStrategy *strategy = nullptr);
+  PageGuard NewPageGuarded(page_id_t &page_id,
+                           PageClass page_class = PageClass::DATA);
+
+  // start reading page_id into the pool in the background, without pinning it
+  // strategy: the frame is taken from the ring, as FetchPage does
+  virtual void Prefetch(page_id_t page_id,
+                        BufferAccessStrategy *strategy = nullptr) = 0;
+
+  virtual bool FlushPage(page_id_t page_id) = 0;
+  // write back every dirty page of the pool, or those with an id in
+  // [first_page_id, last_page_id], in page id order with consecutive pages
+  // batched into single writes. Returns the number of pages written
+  virtual size_t FlushAllPages() = 0;
+  virtual size_t FlushPages(page_id_t first_page_id,
+                            page_id_t last_page_id) = 0;
+
+  virtual Page *NewPage(page_id_t &page_id,
+                        PageClass page_class = PageClass::DATA) = 0;
+
+  virtual bool DeletePage(page_id_t page_id) = 0;
+
+  // number of frames of the pool
+  virtual size_t GetPoolSize() const = 0;
 
-  ~BufferPoolManager();
+  // change the number of frames at runtime, returns the new number of frames
+  // (a shrink stops early when the remaining frames are all pinned)
+  virtual size_t Resize(size_t new_size) = 0;
 
-  Page *FetchPage(page_id_t page_id);
+  // background page cleaner: keep target_clean_frames frames at the cold end
+  // of the replacer clean by writing them back ahead of eviction, at most
+  // max_writes_per_second pages per second
+  virtual void StartCleaner(size_t target_clean_frames,
+                            size_t max_writes_per_second) = 0;
+  virtual void StopCleaner() = 0;
 
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
+  // dirty pages written back on eviction / by the page cleaner
+  virtual size_t GetForegroundWrites() const = 0;
+  virtual size_t GetBackgroundWrites() const = 0;
 
-  bool FlushPage(page_id_t page_id);
+  // hit/miss counts, evictions, write-backs and fetch latencies so far, and
+  // the resident pages of every class now
+  virtual BufferPoolMetricsSnapshot GetMetrics() = 0;
 
-  Page *NewPage(page_id_t &page_id);
+  // warm-up: the ids of the resident pages are kept in file_name. A file left
+  // by the previous run is read back into free frames by a background thread
+  // right away, and the file is written again at shutdown
+  virtual void EnableWarmUp(const std::string &file_name) = 0;
+  // write the resident page ids to the warm-up file now, e.g. at checkpoint
+  virtual bool DumpResidentPages() = 0;
+  // wait until the background warm-up is done
+  virtual void WaitForWarmUp() = 0;
 
-  bool DeletePage(page_id_t page_id);
+  // keep evicted pages compressed in memory, at most budget bytes of them,
+  // see compressed_page_cache.h. Call it once, before the pool is used
+  virtual void EnableCompressedCache(size_t budget) = 0;
 
-  void ShowPinCount(page_id_t page_id);
-private:
-  size_t pool_size_; // number of pages in buffer pool
-  Page *pages_;      // array of pages
-  DiskManager *disk_manager_;
-  LogManager *log_manager_;
-  HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
-  Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
-  std::list<Page *> *free_list_; // to find a free page for replacement
-  std::mutex latch_;             // to protect shared data structure
+  // keep evicted pages in a cache file of num_slots pages on a faster volume,
+  // see flash_cache.h. Call it once, before the pool is used
+  virtual void EnableFlashCache(const std::string &file_name,
+                                size_t num_slots) = 0;
 };
 } // namespace cmudb
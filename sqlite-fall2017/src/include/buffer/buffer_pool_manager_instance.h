@@ -0,0 +1,183 @@
+/*
+ * buffer_pool_manager_instance.h
+ *
+ * Functionality: A buffer pool of its own frames, page table, replacer and
+ * free list, all protected by a single latch. See buffer_pool_manager.h for
+ * the interface.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/flash_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/priority_replacer.h"
+#include "disk/disk_manager.h"
+#include "hash/extendible_hash.h"
+#include "hash/linear_hash.h"
+#include "logging/log_manager.h"
+
+namespace cmudb {
+class BufferPoolManagerInstance : public BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+
+public:
+  // page_table_type: implementation of the page table
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU,
+                            HashTableType page_table_type =
+                                HashTableType::EXTENDIBLE);
+
+  ~BufferPoolManagerInstance();
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr,
+                  PageClass page_class = PageClass::DATA) override;
+
+  Page *FetchPageIfResident(page_id_t page_id) override;
+
+  size_t FetchPages(const page_id_t *page_ids, size_t count,
+                    Page **pages) override;
+
+  Page *FetchChild(Page *parent, page_id_t child_id) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool UnpinPage(Page *page, bool is_dirty) override;
+
+  void Prefetch(page_id_t page_id,
+                BufferAccessStrategy *strategy = nullptr) override;
+
+  bool FlushPage(page_id_t page_id) override;
+  size_t FlushAllPages() override;
+  size_t FlushPages(page_id_t first_page_id, page_id_t last_page_id) override;
+
+  Page *NewPage(page_id_t &page_id,
+                PageClass page_class = PageClass::DATA) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  void ShowPinCount(page_id_t page_id);
+
+  inline size_t GetPoolSize() const override { return pool_size_; }
+
+  size_t Resize(size_t new_size) override;
+
+  void StartCleaner(size_t target_clean_frames,
+                    size_t max_writes_per_second) override;
+  void StopCleaner() override;
+
+  inline size_t GetForegroundWrites() const override {
+    return metrics_.Snapshot().foreground_writes;
+  }
+  inline size_t GetBackgroundWrites() const override {
+    return metrics_.Snapshot().background_writes;
+  }
+
+  BufferPoolMetricsSnapshot GetMetrics() override;
+
+  // bytes of frame memory held now, a shrink gives memory back
+  size_t GetFrameMemory();
+
+  void EnableWarmUp(const std::string &file_name) override;
+  bool DumpResidentPages() override;
+  void WaitForWarmUp() override;
+
+  void EnableCompressedCache(size_t budget) override;
+  // nullptr when the compressed cache is off
+  inline CompressedPageCache *GetCompressedCache() const {
+    return compressed_cache_;
+  }
+
+  void EnableFlashCache(const std::string &file_name,
+                        size_t num_slots) override;
+  // nullptr when the flash cache is off
+  inline FlashCache *GetFlashCache() const { return flash_cache_; }
+
+private:
+  Page *GetVictimPage(BufferAccessStrategy *strategy);
+
+  Page *TakeFreeFrame();
+
+  Page *CreateFrame();
+
+  void DropPin(Page *page);
+
+  bool UnpinFrame(Page *page, bool is_dirty);
+
+  Replacer<Page *> *CreateReplacer();
+
+  // allocate_id false: page_id was allocated by the caller, for
+  // ParallelBufferPoolManager, which routes a new page by its id
+  Page *CreatePage(page_id_t &page_id, PageClass page_class, bool allocate_id);
+
+  void WaitForIO(std::unique_lock<std::mutex> &lock, Page *page);
+
+  // write a resident page back to disk, dropping stale copies of the tiers
+  void WritePage(Page *page);
+
+  // read a page missed by the pool into data, trying the lower tiers first
+  void ReadPage(page_id_t page_id, char *data);
+  void ReadPages(const std::vector<Page *> &pages);
+
+  void Swizzle(Page *parent, Page *child);
+
+  void Unswizzle(Page *page);
+
+  void RunCleaner();
+
+  void RunPrefetcher();
+
+  void RunWarmUp(std::vector<page_id_t> page_ids);
+
+  std::atomic<size_t> pool_size_; // number of pages in buffer pool
+  DiskManager *disk_manager_;
+  LogManager *log_manager_;
+  ReplacerType replacer_type_;
+  std::unordered_set<Page *> frames_; // all the frames, protected by latch_
+  std::vector<Page *> released_frames_; // frames Resize() took out of frames_
+  FrameArena frame_arena_;             // memory of frames_, protected by latch_
+  // frame number of the next frame created, never reused so a released frame
+  // left in the replacer can not alias a new one. Protected by latch_
+  size_t next_frame_id_ = 0;
+  HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
+  Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
+  std::list<Page *> *free_list_; // to find a free page for replacement
+  std::mutex latch_;             // to protect shared data structure
+  std::condition_variable io_cv_; // signaled when a page read completes
+  // page cleaner
+  std::thread *cleaner_thread_;
+  bool cleaner_running_;        // protected by cleaner_latch_
+  std::mutex cleaner_latch_;
+  std::condition_variable cleaner_cv_; // to stop the cleaner without waiting
+  size_t target_clean_frames_;
+  size_t max_writes_per_second_;
+  BufferPoolMetrics metrics_;
+  // prefetch thread, started by the first Prefetch call
+  std::thread *prefetch_thread_;
+  bool prefetch_running_;                // protected by prefetch_latch_
+  std::deque<Page *> prefetch_queue_;    // frames waiting for their read
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  // warm-up
+  std::string warm_up_file_;      // empty when warm-up is off
+  std::thread *warm_up_thread_;
+  std::atomic<bool> warm_up_running_; // cleared to stop the thread early
+  CompressedPageCache *compressed_cache_; // second tier, may be nullptr
+  FlashCache *flash_cache_;               // third tier, may be nullptr
+};
+} // namespace cmudb
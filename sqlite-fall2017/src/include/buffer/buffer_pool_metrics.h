@@ -0,0 +1,107 @@
+/**
+ * buffer_pool_metrics.h
+ *
+ * Functionality: Counters and fetch latency histograms of a buffer pool.
+ * Every thread records into its own padded shard with relaxed atomic adds,
+ * so recording never takes a lock and threads do not write the same cache
+ * line. Snapshot() adds up the shards on demand.
+ *
+ * Latencies are kept in power of two buckets of nanoseconds: bucket i counts
+ * latencies in [2^i, 2^(i+1)) ns, the last bucket everything above.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+#define METRICS_LATENCY_BUCKETS 32 // ~4 seconds in the last bucket
+#define METRICS_SHARDS 16          // threads beyond this share shards
+
+struct BufferPoolMetricsSnapshot {
+  uint64_t hits = 0;              // FetchPage found the page in the pool
+  uint64_t misses = 0;            // FetchPage read the page from disk
+  uint64_t evictions = 0;         // a resident page gave up its frame
+  uint64_t foreground_writes = 0; // dirty victims written on eviction
+  uint64_t background_writes = 0; // dirty pages written by the page cleaner
+  uint64_t frame_wait_ns = 0;     // time spent finding a frame for a page
+  uint64_t hit_latency[METRICS_LATENCY_BUCKETS] = {};
+  uint64_t miss_latency[METRICS_LATENCY_BUCKETS] = {};
+  // resident pages of every PageClass when the snapshot was taken
+  uint64_t resident_pages[NUM_PAGE_CLASSES] = {};
+
+  inline double HitRatio() const {
+    return hits + misses == 0 ? 0 : 1.0 * hits / (hits + misses);
+  }
+
+  // exclusive upper bound of latency bucket i in nanoseconds
+  static inline uint64_t BucketUpperBound(int i) { return 2ULL << i; }
+
+  BufferPoolMetricsSnapshot &operator+=(const BufferPoolMetricsSnapshot &rhs);
+};
+
+class BufferPoolMetrics {
+public:
+  inline void RecordHit(uint64_t latency_ns) {
+    Shard &shard = LocalShard();
+    Add(shard.hits, 1);
+    Add(shard.hit_latency[Bucket(latency_ns)], 1);
+  }
+
+  inline void RecordMiss(uint64_t latency_ns) {
+    Shard &shard = LocalShard();
+    Add(shard.misses, 1);
+    Add(shard.miss_latency[Bucket(latency_ns)], 1);
+  }
+
+  inline void RecordEviction() { Add(LocalShard().evictions, 1); }
+
+  inline void RecordForegroundWrite() {
+    Add(LocalShard().foreground_writes, 1);
+  }
+
+  inline void RecordBackgroundWrite() {
+    Add(LocalShard().background_writes, 1);
+  }
+
+  inline void RecordFrameWait(uint64_t wait_ns) {
+    Add(LocalShard().frame_wait_ns, wait_ns);
+  }
+
+  BufferPoolMetricsSnapshot Snapshot() const;
+
+private:
+  struct Shard {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> foreground_writes{0};
+    std::atomic<uint64_t> background_writes{0};
+    std::atomic<uint64_t> frame_wait_ns{0};
+    std::atomic<uint64_t> hit_latency[METRICS_LATENCY_BUCKETS] = {};
+    std::atomic<uint64_t> miss_latency[METRICS_LATENCY_BUCKETS] = {};
+    // a full cache line between two shards, alignas would need C++17 new
+    char padding[64];
+  };
+
+  static inline void Add(std::atomic<uint64_t> &counter, uint64_t n) {
+    counter.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  static inline int Bucket(uint64_t ns) {
+    if (ns < 2)
+      return 0;
+    int bucket = 63 - __builtin_clzll(ns);
+    return bucket < METRICS_LATENCY_BUCKETS ? bucket
+                                            : METRICS_LATENCY_BUCKETS - 1;
+  }
+
+  Shard &LocalShard();
+
+  Shard shards_[METRICS_SHARDS];
+};
+
+} // namespace cmudb
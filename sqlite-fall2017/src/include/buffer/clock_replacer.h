@@ -0,0 +1,64 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK (second chance) replacement policy. Every frame owns
+ * one atomic reference bit. Insert (unpin) and Erase (pin) only flip atomic
+ * flags and never take a lock; only Victim takes the latch and advances the
+ * clock hand.
+ *
+ * Slots are indexed by frame number (see FrameOf()). They live in segments
+ * that are allocated once and never move, each one twice as large as the one
+ * before, so a frame added to a growing pool gets a slot while Insert/Erase
+ * of the other frames go on without locking. No slot is ever freed.
+ */
+
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+public:
+  // frames: the values this replacer holds at first, slots of other values
+  // are added by Insert
+  ClockReplacer(const std::vector<T> &frames);
+
+  ~ClockReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  void PeekVictims(size_t n, std::vector<T> &values);
+
+  size_t Size();
+
+private:
+  struct Slot {
+    T value;
+    std::atomic<bool> known{false};     // value is set
+    std::atomic<bool> evictable{false}; // unpinned and inside the replacer
+    std::atomic<bool> ref{false};       // second chance bit
+  };
+  // slot of frame, nullptr if its segment is not allocated yet
+  Slot *GetSlot(size_t frame);
+  // slot of frame, allocated if needed and holding value
+  Slot *AddSlot(size_t frame, const T &value);
+
+  // segment i holds FIRST_SEGMENT << i slots
+  static const size_t FIRST_SEGMENT = 64;
+  static const size_t MAX_SEGMENTS = 48;
+  std::atomic<Slot *> segments_[MAX_SEGMENTS];
+  std::atomic<size_t> num_slots_; // slots of the allocated segments
+  std::atomic<size_t> size_;
+  size_t hand_;       // protected by victim_latch_
+  std::mutex victim_latch_; // also taken to allocate a segment
+};
+
+} // namespace cmudb
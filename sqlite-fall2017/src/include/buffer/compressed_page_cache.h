@@ -0,0 +1,103 @@
+/**
+ * compressed_page_cache.h
+ *
+ * Functionality: Second tier of the buffer pool, in memory. Pages evicted
+ * from the pool whose disk copy is up to date are kept here compressed, and
+ * a later miss of the pool is served from here before going to disk.
+ *
+ * Pages are compressed with a small built-in LZ77 codec, a page that does
+ * not compress is kept as is. The cache is exclusive: a page found here is
+ * handed back to the pool and dropped, it comes back on its next eviction.
+ * Once the compressed pages exceed the budget, the least recently stored
+ * ones are dropped, their disk copies are up to date.
+ *
+ * The pool stages pages under its latch (Stage): the page is kept raw right
+ * away and compressed later by a background thread, so the latch is never
+ * held for the codec. A staged page counts raw against the budget until then.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class CompressedPageCache {
+public:
+  // budget: bytes of compressed page data kept at most
+  explicit CompressedPageCache(size_t budget)
+      : budget_(budget), size_(0), next_version_(0),
+        compress_thread_(nullptr), compress_running_(false),
+        compressing_(false) {}
+  ~CompressedPageCache();
+
+  // keep page_data of page_id, which is the same as on disk
+  void Insert(page_id_t page_id, const char *page_data);
+
+  // as Insert, but only copy the page now and compress it in the background
+  void Stage(page_id_t page_id, const char *page_data);
+
+  // wait until every staged page is compressed (or dropped)
+  void WaitForCompression();
+
+  // copy page_id into page_data (PAGE_SIZE bytes) and drop it from the cache,
+  // return false if it is not here
+  bool Lookup(page_id_t page_id, char *page_data);
+
+  // drop page_id, whose disk copy is going away or changing
+  void Erase(page_id_t page_id);
+
+  inline size_t GetBudget() const { return budget_; }
+  // bytes of compressed page data kept now
+  size_t GetSize();
+  size_t GetNumPages();
+  inline size_t GetHits() const { return hits_; }
+  inline size_t GetMisses() const { return misses_; }
+
+  // the codec, exposed for test purpose
+  // compress size bytes of src into dst, return false (dst undefined) if the
+  // result would not be smaller than size
+  static bool Compress(const char *src, size_t size, std::string &dst);
+  // decompress src into size bytes at dst
+  static void Decompress(const std::string &src, char *dst, size_t size);
+
+private:
+  struct Entry {
+    page_id_t page_id;
+    bool compressed; // data holds the raw page otherwise
+    bool staged;     // raw, waiting for the compress thread
+    uint64_t version; // tells a staged page from a later copy of it
+    std::string data;
+  };
+
+  void Store(Entry &&entry);
+  void EraseEntry(std::list<Entry>::iterator it);
+  void RunCompressor();
+
+  size_t budget_;
+  size_t size_; // protected by latch_
+  // least recently stored page at the front, dropped first
+  std::list<Entry> entries_;
+  std::unordered_map<page_id_t, std::list<Entry>::iterator> index_;
+  uint64_t next_version_; // protected by latch_
+  std::mutex latch_;
+  // compress thread, started by the first Stage call
+  std::thread *compress_thread_;
+  bool compress_running_; // protected by latch_
+  bool compressing_;      // a page is out of latch_ being compressed
+  std::deque<std::pair<page_id_t, uint64_t>> staged_; // protected by latch_
+  std::condition_variable compress_cv_;
+  std::condition_variable compressed_cv_; // signaled when staged_ drains
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+};
+
+} // namespace cmudb
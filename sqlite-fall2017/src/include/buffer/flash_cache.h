@@ -0,0 +1,112 @@
+/**
+ * flash_cache.h
+ *
+ * Functionality: Cache file for the buffer pool on a small fast volume, next
+ * to a database file on a slow one. Pages evicted from the pool whose disk
+ * copy is up to date are written to the cache file, and a later miss of the
+ * pool is served from there before going to the database file.
+ *
+ * The file is a ring of page slots written in order, so writes to it are
+ * sequential; a slot that comes round again loses the page it held. Only the
+ * map from page id to slot is kept in memory, so the file is started afresh
+ * at every run.
+ *
+ * A cached copy must never be older than the database file: the pool drops
+ * it (Erase) whenever it writes the page back. Every slot also remembers the
+ * LSN its page was written with, a slot read back with another LSN is torn or
+ * was overwritten, and is treated as a miss. That is a corruption check only,
+ * freshness comes from Erase.
+ *
+ * The pool stages pages under its latch (Stage): the page is copied in memory
+ * and written to its slot by a background thread, served from memory until
+ * then. No file I/O happens under the cache latch either, it is pread/pwrite
+ * on reserved slots.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class FlashCache {
+public:
+  // num_slots: size of the cache file, in pages
+  FlashCache(const std::string &file_name, size_t num_slots);
+  ~FlashCache();
+
+  // write page_data of page_id, which is the same as on disk, to the next
+  // slot. Nothing happens if the file already holds it
+  void Insert(page_id_t page_id, const char *page_data);
+
+  // as Insert, but only copy the page now and write it in the background
+  void Stage(page_id_t page_id, const char *page_data);
+
+  // wait until every staged page is written (or dropped)
+  void WaitForWrites();
+
+  // read page_id into page_data (PAGE_SIZE bytes), return false if it is
+  // not here. The copy stays in the cache
+  bool Lookup(page_id_t page_id, char *page_data);
+
+  // drop page_id, its disk copy is being rewritten or deallocated
+  void Erase(page_id_t page_id);
+
+  inline size_t GetNumSlots() const { return slot_pages_.size(); }
+  size_t GetNumPages();
+  inline size_t GetHits() const { return hits_; }
+  inline size_t GetMisses() const { return misses_; }
+  inline size_t GetWrites() const { return writes_; }
+
+private:
+  struct Entry {
+    size_t slot;
+    lsn_t written_lsn; // LSN of the page when it was written to the slot
+    uint64_t version;
+  };
+  // a page copied in memory, not on file yet
+  struct PendingPage {
+    uint64_t version; // tells this copy from a later one of the same page
+    std::string data;
+  };
+
+  static inline lsn_t PageLSN(const char *page_data) {
+    return *reinterpret_cast<const lsn_t *>(page_data + 4);
+  }
+
+  bool AddPending(page_id_t page_id, const char *page_data);
+  void WriteSlot(page_id_t page_id, std::unique_lock<std::mutex> &lock);
+  void RunWriter();
+
+  std::string file_name_;
+  int fd_;
+  // page held by each slot, INVALID_PAGE_ID if none
+  std::vector<page_id_t> slot_pages_;
+  // reads and writes of each slot in flight, a busy slot is not reused
+  std::vector<int> slot_users_;
+  size_t next_slot_; // next slot of the ring to write
+  std::unordered_map<page_id_t, Entry> index_;
+  std::unordered_map<page_id_t, PendingPage> pending_;
+  uint64_t next_version_;
+  std::mutex latch_; // protects all of the above
+  // writer thread, started by the first Stage call
+  std::thread *writer_thread_;
+  bool writer_running_;            // protected by latch_
+  std::deque<page_id_t> staged_;   // protected by latch_
+  size_t writing_;                 // staged pages being written
+  std::condition_variable writer_cv_;
+  std::condition_variable written_cv_; // signaled when staged_ drains
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+  std::atomic<size_t> writes_{0};
+};
+
+} // namespace cmudb
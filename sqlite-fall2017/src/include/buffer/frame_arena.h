@@ -0,0 +1,73 @@
+/**
+ * frame_arena.h
+ *
+ * Functionality: Memory of the buffer pool frames. Frames are cut out of
+ * large regions instead of being allocated one by one, so they are laid out
+ * next to each other and aligned to DIRECT_IO_ALIGNMENT, as O_DIRECT reads
+ * and writes require (see DiskManager). A region of at least HUGE_PAGE_SIZE
+ * is aligned to a huge page and advised to the kernel as transparent huge
+ * page memory, which cuts the TLB misses of a large pool; the kernel is free
+ * to ignore the advice, the memory works the same either way.
+ *
+ * The pool grows by adding a region. Frames given back by a shrink are kept
+ * for the next growth, but their memory is returned: a region whose frames
+ * are all given back is released, and in the others every kernel page whose
+ * frames are all given back is advised away (MADV_DONTNEED). Such a page is
+ * zero filled again when a frame in it is handed out.
+ *
+ * Not thread safe, the buffer pool latch protects it.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class FrameArena {
+public:
+  FrameArena();
+  ~FrameArena();
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // make count more frames available, spare frames first, then one region
+  // for the rest
+  void Reserve(size_t count);
+  // PAGE_SIZE bytes of frame memory, Reserve() it first
+  char *Allocate();
+  void Free(char *frame);
+
+  // bytes of the regions advised as huge pages
+  inline size_t GetHugePageBytes() const { return huge_page_bytes_; }
+  // bytes of frame memory held: the regions, less the pages advised away
+  inline size_t GetMappedBytes() const { return mapped_bytes_; }
+
+private:
+  struct Region {
+    size_t bytes;
+    bool huge;                  // advised as huge pages
+    size_t num_spare;           // frames not handed out
+    std::vector<bool> spare;    // by frame
+    uintptr_t first_page;       // first kernel page entirely in the region
+    std::vector<bool> returned; // by kernel page, advised away
+  };
+
+  std::map<char *, Region>::iterator FindRegion(char *frame);
+  void OverlappingPages(const Region &region, char *frame, size_t &first,
+                        size_t &last) const;
+  void ReturnPages(char *base, Region &region, char *frame);
+  void ReleaseRegion(std::map<char *, Region>::iterator it);
+
+  std::map<char *, Region> regions_; // by address
+  std::vector<char *> spare_;        // frames not handed out
+  size_t huge_page_bytes_;
+  size_t mapped_bytes_;
+  size_t os_page_size_; // kernel page, unit of MADV_DONTNEED
+};
+
+} // namespace cmudb
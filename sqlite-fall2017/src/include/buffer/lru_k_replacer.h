@@ -0,0 +1,79 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement policy (O'Neil et al.). The victim is the
+ * value whose K-th most recent access is the oldest. Values with less than K
+ * recorded accesses have an infinite backward K-distance and are evicted
+ * first (oldest first access wins), so pages touched once by a sequential
+ * scan go before pages that are referenced again and again, like index inner
+ * nodes.
+ *
+ * Access history is kept per page, not per frame, and is retained for a
+ * bounded number of recently evicted pages. A page that comes back soon after
+ * eviction keeps its history.
+ *
+ * Every Insert (unpin) counts as one access. Accesses of the same page that
+ * are at most correlated_period ticks apart are correlated (e.g. a scan
+ * reading tuples of one page) and only count once.
+ */
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+public:
+  LRUKReplacer(size_t k = 2, size_t history_size = 1024,
+               uint64_t correlated_period = 1);
+
+  ~LRUKReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  void PeekVictims(size_t n, std::vector<T> &values);
+
+  size_t Size();
+
+private:
+  // (has K accesses, tick of K-th most recent or first access): smaller
+  // means evicted earlier
+  typedef std::pair<int, uint64_t> order_t;
+  struct History {
+    std::deque<uint64_t> accesses; // at most K ticks, most recent at back
+    bool retired = false;          // value is pinned or evicted
+    std::list<int64_t>::iterator retired_pos;
+  };
+  struct Entry {
+    order_t order;
+    int64_t key;
+  };
+  void Retire(int64_t key);
+  order_t OrderOf(const History &history);
+
+  size_t k_;
+  size_t history_size_;
+  uint64_t correlated_period_;
+  uint64_t current_tick_;
+  // page -> access history, for evictable, pinned and recently evicted pages
+  std::unordered_map<int64_t, History> history_;
+  // pages whose history is kept but that are not evictable, oldest first
+  std::list<int64_t> retired_;
+  // evictable values by eviction order, and the reverse lookup
+  std::map<order_t, T> evictable_;
+  std::unordered_map<T, Entry> position_;
+  std::mutex latch_;
+};
+
+} // namespace cmudb
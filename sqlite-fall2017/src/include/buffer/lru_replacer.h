@@ -5,14 +5,17 @@
  * all the pages that are unpinned and ready to be swapped. The simplest way to
  * implement LRU is a FIFO queue, but remember to dequeue or enqueue pages when
  * a page changes from unpinned to pinned, or vice-versa.
+ *
+ * The list is threaded through prev/next arrays indexed by frame number (see
+ * Page::GetFrameId(), an int value is its own number), so Insert/Erase neither
+ * hash nor allocate once the arrays cover all the frames.
  */
 
 #pragma once
-#include <deque>
 #include <mutex>
+#include <vector>
 
 #include "buffer/replacer.h"
-#include "hash/extendible_hash.h"
 #include "common/logger.h"
 
 namespace cmudb {
@@ -20,7 +23,9 @@ namespace cmudb {
 template <typename T> class LRUReplacer : public Replacer<T> {
 public:
   // do not change public interface
-  LRUReplacer();
+  // num_frames: frame numbers below it are set up at once, the arrays grow
+  // on demand for larger ones
+  LRUReplacer(size_t num_frames = 0);
 
   ~LRUReplacer();
 
@@ -30,12 +35,26 @@ public:
 
   bool Erase(const T &value);
 
+  void PeekVictims(size_t n, std::vector<T> &values);
+
   size_t Size();
 
 private:
   // add your member variables here
-  std::deque<T>* deque_;
-  class WfirstRWLock* lk_;
+  void Grow(size_t num_frames);
+  void Unlink(size_t frame);
+
+  // least recently unpinned frame at head_, victim is taken from there.
+  // NIL ends the list, prev_ of a frame not in the list is NOT_LISTED
+  static const size_t NIL = static_cast<size_t>(-1);
+  static const size_t NOT_LISTED = static_cast<size_t>(-2);
+  std::vector<T> values_;
+  std::vector<size_t> prev_;
+  std::vector<size_t> next_;
+  size_t head_;
+  size_t tail_;
+  size_t size_;
+  std::mutex latch_;
 };
 
 } // namespace cmudb
@@ -0,0 +1,79 @@
+/**
+ * page_guard.h
+ *
+ * Functionality: Scoped ownership of a pinned page. A guard unpins its page
+ * when it goes out of scope (or on Release()), handing the frame itself to
+ * BufferPoolManager::UnpinPage(Page *, bool), so unpinning needs no page
+ * table lookup. ReadPageGuard/WritePageGuard also own the read/write latch
+ * of the page and drop it before unpinning.
+ *
+ * Guards are movable but not copyable. A guard of a failed fetch holds no
+ * page, check it with IsValid().
+ */
+
+#pragma once
+
+#include "page/page.h"
+
+namespace cmudb {
+
+class BufferPoolManager;
+
+// pin only, for pages latched by other means (or not at all)
+class PageGuard {
+public:
+  PageGuard() = default;
+  // adopts a pin on page taken from buffer_pool_manager, page may be nullptr
+  PageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+  PageGuard(const PageGuard &) = delete;
+  PageGuard &operator=(const PageGuard &) = delete;
+  PageGuard(PageGuard &&other);
+  PageGuard &operator=(PageGuard &&other);
+  ~PageGuard() { Release(); }
+
+  // unpin the page now, the guard holds nothing afterwards
+  void Release();
+
+  inline bool IsValid() const { return page_ != nullptr; }
+  inline Page *GetPage() const { return page_; }
+  inline page_id_t GetPageId() const { return page_->GetPageId(); }
+  inline char *GetData() const { return page_->GetData(); }
+  // the page is unpinned dirty
+  inline void SetDirty() { is_dirty_ = true; }
+
+protected:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+  bool is_dirty_ = false;
+};
+
+class ReadPageGuard : public PageGuard {
+public:
+  ReadPageGuard() = default;
+  // adopts a pin and the read latch on page
+  ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : PageGuard(buffer_pool_manager, page) {}
+  ReadPageGuard(ReadPageGuard &&other) = default;
+  ReadPageGuard &operator=(ReadPageGuard &&other);
+  ~ReadPageGuard() { Release(); }
+
+  // drop the read latch and unpin the page now
+  void Release();
+};
+
+class WritePageGuard : public PageGuard {
+public:
+  WritePageGuard() = default;
+  // adopts a pin and the write latch on page
+  WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : PageGuard(buffer_pool_manager, page) {}
+  WritePageGuard(WritePageGuard &&other) = default;
+  WritePageGuard &operator=(WritePageGuard &&other);
+  ~WritePageGuard() { Release(); }
+
+  // drop the write latch and unpin the page now
+  void Release();
+};
+
+} // namespace cmudb
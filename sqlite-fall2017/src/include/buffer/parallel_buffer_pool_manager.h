@@ -0,0 +1,105 @@
+/*
+ * parallel_buffer_pool_manager.h
+ *
+ * Functionality: A buffer pool split into num_instances independent
+ * BufferPoolManagerInstances, each with its own latch, page table, replacer
+ * and free list. A page always lives in instance page_id % num_instances, so
+ * threads working on different pages rarely contend on the same latch. New
+ * page ids come from the disk manager and are routed the same way.
+ */
+
+#pragma once
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+
+namespace cmudb {
+class ParallelBufferPoolManager : public BufferPoolManager {
+public:
+  // pool_size: number of frames of each instance
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                            DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU,
+                            HashTableType page_table_type =
+                                HashTableType::EXTENDIBLE);
+
+  ~ParallelBufferPoolManager() override;
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr,
+                  PageClass page_class = PageClass::DATA) override;
+
+  Page *FetchPageIfResident(page_id_t page_id) override;
+
+  // split by instance, each instance fetches its share as one batch
+  size_t FetchPages(const page_id_t *page_ids, size_t count,
+                    Page **pages) override;
+
+  // swizzled only when parent and child belong to the same instance
+  Page *FetchChild(Page *parent, page_id_t child_id) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool UnpinPage(Page *page, bool is_dirty) override;
+
+  void Prefetch(page_id_t page_id,
+                BufferAccessStrategy *strategy = nullptr) override;
+
+  bool FlushPage(page_id_t page_id) override;
+  // every instance flushes its own pages, see BufferPoolManager
+  size_t FlushAllPages() override;
+  size_t FlushPages(page_id_t first_page_id, page_id_t last_page_id) override;
+
+  // the page id comes from disk manager, the page from the instance it maps
+  // to. An id whose instance is full is kept for a later NewPage
+  Page *NewPage(page_id_t &page_id,
+                PageClass page_class = PageClass::DATA) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  // total number of frames of all the instances
+  size_t GetPoolSize() const override;
+
+  // resize every instance to new_size / num_instances frames, the remainder
+  // goes one frame each to the first instances. Returns the new total
+  size_t Resize(size_t new_size) override;
+
+  // start a page cleaner in every instance, both limits are per instance
+  void StartCleaner(size_t target_clean_frames,
+                    size_t max_writes_per_second) override;
+  void StopCleaner() override;
+
+  // sums over all the instances
+  size_t GetForegroundWrites() const override;
+  size_t GetBackgroundWrites() const override;
+  BufferPoolMetricsSnapshot GetMetrics() override;
+
+  // every instance keeps its pages in file_name.<instance index>
+  void EnableWarmUp(const std::string &file_name) override;
+  bool DumpResidentPages() override;
+  void WaitForWarmUp() override;
+
+  // every instance keeps a compressed cache of budget bytes
+  void EnableCompressedCache(size_t budget) override;
+  // every instance has a cache file file_name.<instance index> of num_slots
+  void EnableFlashCache(const std::string &file_name,
+                        size_t num_slots) override;
+
+private:
+  BufferPoolManagerInstance *GetInstance(page_id_t page_id);
+
+  bool TakeSpareId(const std::vector<bool> &tried, page_id_t &page_id);
+  void GiveBackId(page_id_t page_id);
+
+  size_t num_instances_;
+  size_t pool_size_; // initial number of frames of each instance
+  DiskManager *disk_manager_;
+  std::vector<BufferPoolManagerInstance *> instances_;
+  // per instance, ids from disk manager NewPage could not use yet
+  std::vector<std::vector<page_id_t>> spare_ids_;
+  std::mutex spare_latch_; // protects spare_ids_
+};
+} // namespace cmudb
@@ -0,0 +1,46 @@
+/**
+ * priority_replacer.h
+ *
+ * Functionality: Replacement over classes of values. Every class has its own
+ * replacer (of any policy), a victim is taken from the lowest class that has
+ * one, so values of a higher class are only evicted once every lower class
+ * is exhausted.
+ *
+ * The class of a value is read through class_of on Insert and on Erase, so it
+ * must not change while the value is in the replacer. The buffer pool only
+ * changes the class of pinned frames, which the replacer does not hold.
+ */
+
+#pragma once
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class PriorityReplacer : public Replacer<T> {
+public:
+  // replacers: one per class, lowest class first, owned from now on
+  // class_of: index of the class of a value in replacers
+  PriorityReplacer(const std::vector<Replacer<T> *> &replacers,
+                   size_t (*class_of)(const T &));
+
+  ~PriorityReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  // lowest class first, each class in its own victim order
+  void PeekVictims(size_t n, std::vector<T> &values);
+
+  size_t Size();
+
+private:
+  std::vector<Replacer<T> *> replacers_;
+  size_t (*class_of_)(const T &);
+};
+
+} // namespace cmudb
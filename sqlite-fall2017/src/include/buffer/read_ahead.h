@@ -0,0 +1,52 @@
+/**
+ * read_ahead.h
+ *
+ * Functionality: Read-ahead for scans that follow a chain of pages (table
+ * heap pages, b+ tree leaves). The scan tells it which page it moved to, and
+ * it keeps the next window pages of the chain prefetched through
+ * BufferPoolManager::Prefetch, so that crossing a page boundary finds the
+ * next page already read (or at least in flight).
+ *
+ * The id of page i+1 is only known once page i is in memory, so the window
+ * is extended one page at a time from its last page, and only once the read
+ * of that page is complete: read-ahead never waits for I/O or for a latch.
+ * The scan calls Poll() while it stays on a page to extend the window as
+ * reads complete.
+ */
+
+#pragma once
+#include <deque>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+class ReadAhead {
+public:
+  // next_page_id: reads the id of the next page in the chain from a page
+  // strategy: ring of frames of the scan, may be nullptr
+  ReadAhead(BufferPoolManager *buffer_pool_manager,
+            page_id_t (*next_page_id)(Page *), size_t window = READ_AHEAD_WINDOW,
+            BufferAccessStrategy *strategy = nullptr)
+      : buffer_pool_manager_(buffer_pool_manager), next_page_id_(next_page_id),
+        window_(window), strategy_(strategy), chain_end_(false) {}
+
+  // the scan moved to page current, whose next page is next. current is not
+  // fetched again
+  void Advance(page_id_t current, page_id_t next);
+
+  // extend the window from the pages ahead whose read has completed
+  void Poll();
+
+private:
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t (*next_page_id_)(Page *);
+  size_t window_;
+  BufferAccessStrategy *strategy_;
+  // pages prefetched ahead of the scan, in chain order
+  std::deque<page_id_t> in_flight_;
+  // the last page in flight ends the chain, Poll() has nothing to do
+  bool chain_end_;
+};
+
+} // namespace cmudb
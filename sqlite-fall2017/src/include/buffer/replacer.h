@@ -6,9 +6,17 @@
 #pragma once
 
 #include <cstdlib>
+#include <vector>
 
 namespace cmudb {
 
+// replacement policy used by buffer pool manager
+enum class ReplacerType { LRU = 0, CLOCK, LRU_K };
+
+// frame number of a value, for replacers that index their state by frame.
+// Test only, an int is its own frame number. See FrameOf(Page *) in page.h
+inline size_t FrameOf(int value) { return static_cast<size_t>(value); }
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
@@ -16,6 +24,9 @@ public:
   virtual void Insert(const T &value) = 0;
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
+  // append up to n values in the order they would be victimized, without
+  // removing them
+  virtual void PeekVictims(size_t n, std::vector<T> &values) = 0;
   virtual size_t Size() = 0;
 };
 
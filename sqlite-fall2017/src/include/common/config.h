@@ -24,10 +24,30 @@ extern std::atomic<bool> ENABLE_LOGGING;
 #define LOG_BUFFER_SIZE                                                            \
   ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
+#define MERGE_FILL 0.25                // buddy buckets below it are merged
 #define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define BUFFER_POOL_INSTANCES 1        // see ParallelBufferPoolManager
+#define RING_BUFFER_SIZE 4             // frames recycled by a sequential scan
+#define CLEANER_INTERVAL 10            // ms between rounds of the page cleaner
+#define READ_AHEAD_WINDOW 2            // pages a scan prefetches ahead
+#define WARM_UP_BATCH_SIZE 64          // pages per read of the warm-up thread
+#define SWIZZLE_SLOTS 64               // child frames cached per internal page
+#define CACHE_LINE_SIZE 64             // bytes of a cpu cache line
+#define DIRECT_IO_ALIGNMENT 512        // sector size O_DIRECT transfers align to
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024) // transparent huge page of the kernel
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
 typedef int32_t lsn_t;     // log sequence number type
 
+// eviction priority of a page in the buffer pool, lowest first: a page is
+// only evicted once no page of a lower class is left to evict
+enum class PageClass {
+  DATA = 0,       // table pages, and anything not classified
+  INDEX_LEAF,     // b+ tree leaf pages
+  INDEX_INTERNAL, // b+ tree internal pages
+  HEADER          // the header page
+};
+#define NUM_PAGE_CLASSES 4
+
 } // namespace cmudb
\ No newline at end of file
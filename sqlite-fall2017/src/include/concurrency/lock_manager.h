@@ -15,6 +15,7 @@
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "hash/extendible_hash.h"
+#include "hash/linear_hash.h"
 
 namespace cmudb {
 
@@ -23,7 +24,9 @@ enum class LockType { SHARED = 0, EXCLUSIVE, WSHARED, WEXCLUSIVE };
 class LockManager {
 
 public:
-  LockManager(bool strict_2PL);
+  // lock_table_type: implementation of the lock table
+  LockManager(bool strict_2PL,
+              HashTableType lock_table_type = HashTableType::EXTENDIBLE);
   class TxnList;
   /*** below are APIs need to implement ***/
   // lock:
@@ -40,9 +43,18 @@ public:
   bool Unlock(Transaction *txn, const RID &rid);
   /*** END OF APIs ***/
 
+  // expose for test purpose
+  inline HashTable<RID, TxnList *> *GetLockTable() { return lock_table_; }
+
 private:
+  TxnList *AcquireList(const RID &rid, bool create);
+  void ReleaseList(const RID &rid, TxnList *txn_list);
+
   bool strict_2PL_;
   HashTable<RID, TxnList*> *lock_table_; // to keep track of locked tuple
+  // protects lock table entries and TxnList::users_, so a list is created
+  // once per rid and freed once its last request is drained
+  std::mutex table_mutex_;
 };
 
 class LockManager::TxnList{
@@ -56,10 +68,13 @@ public:
   bool Delete(Transaction *txn);
   inline std::unique_lock<std::mutex> GetListLock() {
     std::unique_lock<std::mutex> ulk(list_mutex_);
-    return std::move(ulk); 
+    return ulk;
   }
   inline TxnListNode *GetHead() { return head_; }
   inline void SetHead(TxnListNode *head) { head_ = head; }
+  bool IsEmpty();
+  // calls of LockManager working on this list, see LockManager::AcquireList
+  size_t users_{ 0 };
 private:
   std::mutex list_mutex_;
   std::condition_variable cond_;
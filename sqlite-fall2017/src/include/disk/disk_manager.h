@@ -5,12 +5,25 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * In direct I/O mode pages of the database file are read and written with
+ * O_DIRECT, bypassing the page cache of the kernel, so a page is not held in
+ * memory twice, by the buffer pool and by the kernel. Transfers must then be
+ * aligned to DIRECT_IO_ALIGNMENT: buffer pool frames are (see FrameArena),
+ * other buffers go through an aligned bounce buffer. Where the file system
+ * rejects O_DIRECT, at open or at the first transfer, the disk manager falls
+ * back to buffered I/O for good.
+ *
+ * WritePages writes a batch of pages, every run of consecutive page ids as
+ * one vectored write, through a descriptor of its own when the file is not
+ * opened for direct I/O.
  */
 
 #pragma once
 #include <atomic>
 #include <fstream>
 #include <future>
+#include <mutex>
 #include <string>
 
 #include "common/config.h"
@@ -19,11 +32,17 @@ namespace cmudb {
 
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  DiskManager(const std::string &db_file, bool direct_io = false);
   ~DiskManager();
 
   void WritePage(page_id_t page_id, const char *page_data);
+  // write count pages, page_ids sorted ascending. Returns the number of
+  // write calls issued
+  int WritePages(const page_id_t *page_ids, const char *const *page_data,
+                 int count);
   void ReadPage(page_id_t page_id, char *page_data);
+  // read count pages in one go, page_ids sorted ascending
+  void ReadPages(const page_id_t *page_ids, char *const *page_data, int count);
 
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
@@ -32,20 +51,40 @@ public:
   void DeallocatePage(page_id_t page_id);
 
   int GetNumFlushes() const;
+  int GetNumReads() const;
   bool GetFlushState() const;
+  // false once direct I/O fell back to buffered I/O, or if never asked for
+  inline bool IsDirectIO() const { return direct_io_; }
   inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
 private:
   int GetFileSize(const std::string &name);
+  // a page transfer through db_fd_, false if O_DIRECT was rejected and the
+  // caller should use db_io_ instead
+  bool DirectRead(page_id_t page_id, char *page_data);
+  bool DirectWrite(page_id_t page_id, const char *page_data);
+  // one pwritev of count consecutive pages, false as DirectWrite
+  bool WriteRun(const page_id_t *page_ids, const char *const *page_data,
+                int count);
+  void DisableDirectIO();
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
   // stream to write db file
   std::fstream db_io_;
   std::string file_name_;
+  // db_io_ has one cursor, shared by all buffer pool instances
+  std::mutex db_io_latch_;
+  // db file opened with O_DIRECT in direct I/O mode, without otherwise,
+  // -1 if it can't be opened. Protected by db_io_latch_ like the aligned page
+  // bounce_ buffer
+  int db_fd_;
+  std::atomic<bool> direct_io_;
+  char *bounce_;
   std::atomic<page_id_t> next_page_id_;
   int num_flushes_;
+  std::atomic<int> num_reads_; // number of page reads
   bool flush_log_;
   std::future<void> *flush_log_f_;
 };
@@ -5,11 +5,40 @@
  * Functionality: The buffer pool manager must maintain a page table to be able
  * to quickly map a PageId to its corresponding memory location; or alternately
  * report that the PageId does not match any currently-buffered page.
+ *
+ * A bucket is a single cache line aligned block: the bucket header, then one
+ * byte of fingerprint per slot (0 for an empty slot), then the keys and the
+ * values. A lookup compares its fingerprint with FINGERPRINT_GROUP slots at
+ * once (AVX2 or SSE2 where the compiler targets them) and only compares the
+ * keys of the matching slots.
+ *
+ * Find does not lock when keys and values are trivially copyable: it reads
+ * the bucket optimistically and validates the bucket version afterwards, the
+ * way Page::OptimisticRead() works. Insert and Remove make the version odd
+ * while they change a bucket. A split fills the new buckets first, then
+ * publishes them in the directory, and leaves the old bucket with an odd
+ * version for good. Doubling publishes a new directory array through the
+ * atomic directory pointer. So readers never wait for the table to grow;
+ * after OPTIMISTIC_RETRIES failed validations a reader takes the locks.
+ *
+ * Old buckets and directory arrays may still be read by optimistic readers,
+ * they are retired and freed once every reader shard has been seen empty at
+ * least once since, each shard at its own moment: busy shards never need to
+ * be empty all at the same time.
+ *
+ * With a merge fill above 0, Remove merges a bucket with its buddy (the
+ * bucket it was split from) while the two hold at most merge_fill *
+ * bucket size entries together, and halves the directory once no bucket
+ * uses its top bit, so a table shrinks back after a spike. Keep merge_fill
+ * well below 1/2, a bucket just split holds about half of it.
  */
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
+#include <type_traits>
 #include <vector>
 #include <string>
 #include <math.h>
@@ -18,10 +47,22 @@
 #include <mutex>
 #include <condition_variable>
 
+#include "common/config.h"
 #include "hash/hash_table.h"
 #include "concurrency/lock_manager.h"
 
 namespace cmudb {
+
+#if defined(__AVX2__)
+#define FINGERPRINT_GROUP 32 // slots matched by one compare
+#elif defined(__SSE2__)
+#define FINGERPRINT_GROUP 16
+#else
+#define FINGERPRINT_GROUP 8
+#endif
+#define OPTIMISTIC_RETRIES 8 // failed validations before Find takes the locks
+#define READER_SHARDS 32     // threads beyond this share reader counters
+
 class WfirstRWLock{
 public:
   WfirstRWLock() = default;
@@ -76,8 +117,8 @@ template <typename K, typename V>
 class ExtendibleHash : public HashTable<K, V> {
   static const int max_global_depth;
 public:
-  // constructor
-  ExtendibleHash(size_t size);
+  // constructor, merge_fill 0 never merges buckets
+  ExtendibleHash(size_t size, double merge_fill = 0);
   ~ExtendibleHash();
   // helper function to generate hash addressing
   size_t HashKey(const K &key);
@@ -90,26 +131,92 @@ public:
   bool Remove(const K &key) override;
   void Insert(const K &key, const V &value) override;
   // added by me
+  // header of a bucket block, the arrays point into the same block
   struct bucket{
     int bucket_id;
     int local_depth;
+    std::atomic<uint64_t> version; // odd while changed, and once retired
     class WfirstRWLock* local_lk;
-    bool* occupied_flag_array;
+    uint8_t* fingerprints; // padded to whole groups, 0 for an empty slot
     K* keys_array;
     V* val_array;
   };
   long long unsigned Hash(const K &key);
-  bool SafeInsert(const K &key, const V &value);
+  bool SafeInsert(struct bucket* p, const K &key, const V &value);
   void debug(int mode);
+  // expose for test purpose: objects retired and not freed yet, and an
+  // optimistic reader held in a shard, as a Find preempted mid-read
+  size_t GetRetiredCount();
+  inline void EnterReaderShard(unsigned shard) {
+    reader_shards[shard].readers.fetch_add(1);
+  }
+  inline void LeaveReaderShard(unsigned shard) {
+    reader_shards[shard].readers.fetch_sub(1);
+  }
 private:
+  // an array of 2^global_depth bucket pointers, with its mask
+  struct dir{
+    size_t depth_mask;
+    std::atomic<struct bucket*>* buckets;
+  };
+  // optimistic readers of one group of threads, padded to a cache line
+  struct reader_shard{
+    std::atomic<size_t> readers{0};
+    char padding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+  };
+  // objects retired together, with the shards not seen empty since
+  struct retired_batch{
+    uint64_t busy_shards; // bit per reader shard
+    std::vector<struct bucket*> buckets;
+    std::vector<struct dir*> dirs;
+  };
+  static_assert(READER_SHARDS <= 64, "a batch keeps a bit per reader shard");
+  static constexpr bool optimistic = std::is_trivially_copyable<K>::value &&
+                                     std::is_trivially_copyable<V>::value;
+  bool LockedFind(long long unsigned hash, const K &key, V &value);
+  // free what was retired if no optimistic reader can still hold it
+  void ReclaimRetired();
+  struct dir* NewDir(int depth);
+  void DeleteDir(struct dir* d);
+  struct bucket* NewBucket(int bucket_id, int local_depth);
+  // bracket a change of a published bucket, see Page::BeginWrite()
+  static inline void BeginWrite(struct bucket* p) {
+    p->version.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+  static inline void EndWrite(struct bucket* p) {
+    p->version.fetch_add(1, std::memory_order_release);
+  }
+  void DeleteBucket(struct bucket* p);
+  uint8_t Fingerprint(long long unsigned hash) const;
+  // offset of key in p, or -1
+  int FindSlot(struct bucket* p, const K &key, uint8_t fingerprint) const;
+  // offset of an empty slot of p, or -1
+  int FindEmptySlot(struct bucket* p) const;
+  size_t CountEntries(struct bucket* p) const;
+  // merge the bucket of hash with its buddy while they underflow, then
+  // shrink the directory
+  void Merge(long long unsigned hash);
   // add your own member variables here
   size_t bucket_size;
+  size_t merge_limit; // entries two buddies may hold to be merged
+  // layout of a bucket block
+  size_t fingerprint_groups;
+  size_t keys_offset;
+  size_t vals_offset;
+  size_t bucket_bytes;
   int global_depth;
+  int deepest_buckets; // buckets with local depth == global depth
   int bucket_num;
-  size_t depth_mask;
-  struct bucket** directory;
+  int next_bucket_id;
+  std::atomic<struct dir*> directory;
   class WfirstRWLock* global_lk;
-  class WfirstRWLock* mask_lk;
+  // retired by splits and merges since the last ReclaimRetired, then the
+  // batches waiting for their shards, protected by global_lk
+  std::vector<struct bucket*> retired_buckets;
+  std::vector<struct dir*> retired_dirs;
+  std::vector<retired_batch> retired_batches;
+  reader_shard reader_shards[READER_SHARDS];
 };
 template <typename K, typename V>
 const int ExtendibleHash<K, V>::max_global_depth = 
@@ -8,6 +8,10 @@
 
 namespace cmudb {
 
+// implementation chosen for the page table and the lock table, see
+// extendible_hash.h and linear_hash.h
+enum class HashTableType { EXTENDIBLE = 0, LINEAR };
+
 template <typename K, typename V> class HashTable {
 public:
   HashTable() {}
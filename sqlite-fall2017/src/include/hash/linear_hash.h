@@ -0,0 +1,79 @@
+/*
+ * linear_hash.h : implementation of in-memory hash table using linear hashing
+ *
+ * Functionality: the same HashTable as ExtendibleHash, for the page table and
+ * the lock table, but the table grows one bucket at a time: an Insert that
+ * takes the average bucket load above the bucket size splits the bucket at
+ * the split pointer, and nothing else. There is no directory to double, so no
+ * Insert ever pays for more than one bucket of entries.
+ *
+ * With 2^level <= n < 2^(level+1) buckets, a key goes to bucket
+ * hash mod 2^level, or hash mod 2^(level+1) when that bucket has already been
+ * split in this round (it is below the split pointer n - 2^level). A bucket
+ * is a vector of entries, so a bucket not split yet can hold more than the
+ * bucket size until the split pointer reaches it.
+ *
+ * The buckets live in segments that double in size, segment 0 holding
+ * buckets 0 and 1 and segment k buckets [2^k, 2^(k+1)), so a segment is never
+ * copied or moved. Find, Insert and Remove lock the bucket of the key only,
+ * and check once it is locked that it is still the bucket of the key; a
+ * split locks the bucket it splits, fills the new one, and then publishes
+ * the new bucket count.
+ *
+ * The table does not shrink, buckets are freed by the destructor.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "hash/hash_table.h"
+
+namespace cmudb {
+
+#define LINEAR_HASH_SEGMENTS 64 // segment k holds 2^k buckets
+
+template <typename K, typename V>
+class LinearHash : public HashTable<K, V> {
+public:
+  // size: average number of entries per bucket the table grows to keep
+  LinearHash(size_t size);
+  ~LinearHash();
+  LinearHash(const LinearHash &) = delete;
+  LinearHash &operator=(const LinearHash &) = delete;
+
+  // lookup and modifier
+  bool Find(const K &key, V &value) override;
+  bool Remove(const K &key) override;
+  void Insert(const K &key, const V &value) override;
+
+  inline size_t GetNumBuckets() const { return num_buckets_.load(); }
+  inline size_t GetSize() const { return size_.load(); }
+
+private:
+  struct bucket {
+    std::mutex latch;
+    std::vector<std::pair<K, V>> entries;
+  };
+
+  uint64_t Hash(const K &key) const;
+  // bucket of hash when the table has num_buckets buckets
+  static size_t Address(uint64_t hash, size_t num_buckets);
+  // the bucket of hash, locked
+  bucket *LockBucket(uint64_t hash);
+  bucket *GetBucket(size_t index) const;
+  // split the bucket at the split pointer, unless another thread is splitting
+  void Split();
+
+  size_t bucket_size_;
+  std::atomic<size_t> num_buckets_; // level and split pointer, see Address()
+  std::atomic<size_t> size_;        // number of entries
+  std::mutex split_latch_;          // one split at a time
+  std::atomic<std::atomic<bucket *> *> segments_[LINEAR_HASH_SEGMENTS];
+};
+
+} // namespace cmudb
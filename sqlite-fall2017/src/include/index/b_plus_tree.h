@@ -73,8 +73,35 @@ public:
     if(page == nullptr)
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while printing");
+    ClassifyPage(page);
     return page;
   }
+  // descent step, through the swizzled frames of parent
+  inline Page *ChildPage(Page *parent, page_id_t page_id){
+    auto page = buffer_pool_manager_->FetchChild(parent, page_id);
+    if(page == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "all page are pinned while printing");
+    ClassifyPage(page);
+    return page;
+  }
+  inline PageGuard PageID2Guard(page_id_t page_id){
+    PageGuard guard = buffer_pool_manager_->FetchPageGuarded(page_id);
+    if(!guard.IsValid())
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "all page are pinned while printing");
+    ClassifyPage(guard.GetPage());
+    return guard;
+  }
+  // eviction class of a pinned tree page, by its node type. Only written
+  // when it changes, the root is fetched by every descent
+  inline void ClassifyPage(Page *page){
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    PageClass page_class = node->IsLeafPage() ? PageClass::INDEX_LEAF
+                                              : PageClass::INDEX_INTERNAL;
+    if(page->GetPageClass() != page_class)
+      page->SetPageClass(page_class);
+  }
   inline BPlusTreePage *PageID2Node(page_id_t page_id){
     auto page = PageID2Page(page_id);
     BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
@@ -137,7 +164,7 @@ public:
       auto page = page_set->front();
       page_set->pop_front();
       UnLockPage(page, t_mode);
-      assert(buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty));
+      buffer_pool_manager_->UnpinPage(page, dirty);
     }
     //LOG_DEBUG("start..");
   }
@@ -152,12 +179,13 @@ public:
       page_id_t page_id = *iter1;
       for(auto iter = page_set->cbegin(); iter != page_set->cend(); iter++)
         if((*iter)->GetPageId() == page_id){
+          Page *page = *iter;
           page_set->erase(iter);
-          UnLockPage(*iter, TraverseMode::DELETE);
-          assert(buffer_pool_manager_->UnpinPage(page_id, true));    
+          UnLockPage(page, TraverseMode::DELETE);
+          buffer_pool_manager_->UnpinPage(page, true);
           break;
         }
-      assert(buffer_pool_manager_->DeletePage(page_id));
+      buffer_pool_manager_->DeletePage(page_id);
     }
     delete_page_set->clear();
   }
@@ -171,7 +199,8 @@ private:
                         BPlusTreePage *new_node,
                         Transaction *transaction = nullptr);
 
-  template <typename N> N *Split(N *node);
+  // new_page: guard of the page of the returned node
+  template <typename N> N *Split(N *node, PageGuard &new_page);
 
   template <typename N>
   bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
@@ -0,0 +1,99 @@
+/**
+ * extendible_hash_table.h
+ *
+ * Disk-resident extendible hash table: a directory (see
+ * page/hash_table_directory_page.h) maps the last GlobalDepth bits of the
+ * hash of a key to a bucket page (see page/hash_table_bucket_page.h). A point
+ * lookup reads the directory page, one directory segment and one bucket; the
+ * directory pages are fetched as internal index pages, which the buffer pool
+ * keeps over the buckets, so it mostly costs the bucket read.
+ * (1) We only support unique key
+ * (2) a full bucket is split, doubling the directory if needed; once the
+ *     directory has DIRECTORY_MAX_SLOTS slots, a full bucket gets overflow
+ *     buckets
+ * (3) buckets are not merged on remove
+ *
+ * Latching: the directory page latch is taken first, it covers the segments,
+ * then the bucket latch, which covers the overflow buckets linked from it.
+ * Only a split takes the directory write latch; lookups, removes and inserts
+ * into a bucket with room let go of the directory latch once they hold the
+ * bucket latch.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "concurrency/transaction.h"
+#include "page/hash_table_bucket_page.h"
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+#define EXTENDIBLE_HASH_TABLE_TYPE                                             \
+  ExtendibleHashTable<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class ExtendibleHashTable {
+public:
+  // directory_page_id: directory of an existing table. Without it, a new
+  // table is created and its directory page id recorded in the header page
+  // under name
+  explicit ExtendibleHashTable(const std::string &name,
+                               BufferPoolManager *buffer_pool_manager,
+                               const KeyComparator &comparator,
+                               page_id_t directory_page_id = INVALID_PAGE_ID);
+
+  // Insert a key-value pair, false if the key is already there
+  bool Insert(const KeyType &key, const ValueType &value,
+              Transaction *transaction = nullptr);
+
+  // Remove a key and its value, false if the key is not there
+  bool Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key
+  bool GetValue(const KeyType &key, std::vector<ValueType> &result,
+                Transaction *transaction = nullptr);
+
+  inline page_id_t GetDirectoryPageId() const { return directory_page_id_; }
+  // expose for test purpose
+  uint32_t GetGlobalDepth();
+
+private:
+  uint32_t Hash(const KeyType &key) const;
+  Page *FetchPage(page_id_t page_id, PageClass page_class);
+  Page *NewBucketPage(page_id_t &page_id);
+  inline HashTableDirectoryPage *DirectoryOf(Page *page) {
+    return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  }
+  inline HashTableSegmentPage *SegmentOf(Page *page) {
+    return reinterpret_cast<HashTableSegmentPage *>(page->GetData());
+  }
+  inline HASH_TABLE_BUCKET_PAGE_TYPE *BucketOf(Page *page) {
+    return reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(page->GetData());
+  }
+  Page *NewSegmentPage(page_id_t &page_id);
+  // bucket page id and local depth of directory slot index
+  page_id_t GetSlot(HashTableDirectoryPage *directory, uint32_t index,
+                    uint32_t &local_depth);
+  // whether a bucket of local_depth can be split
+  static bool CanSplit(HashTableDirectoryPage *directory,
+                       uint32_t local_depth);
+  // the new upper half of the slots points to the same buckets as the lower
+  void DoubleDirectory(HashTableDirectoryPage *directory);
+  // insert into bucket_page, which is write latched, or its overflow buckets
+  bool InsertIntoChain(Page *bucket_page, const KeyType &key,
+                       const ValueType &value);
+  // split the bucket of directory slot index, which is write latched, along
+  // the next hash bit. The directory must be write latched
+  void SplitBucket(HashTableDirectoryPage *directory, uint32_t index,
+                   uint32_t local_depth, Page *bucket_page);
+
+  // member variable
+  std::string index_name_;
+  page_id_t directory_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+};
+
+} // namespace cmudb
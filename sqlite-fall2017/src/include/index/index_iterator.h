@@ -3,6 +3,7 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include "buffer/read_ahead.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace cmudb {
@@ -37,10 +38,12 @@ public:
   inline void UnlockPage(){
     auto page = buffer_pool_manager_->FetchPage(node_->GetPageId());
     page->WUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(node_->GetPageId(), true));
+    buffer_pool_manager_->UnpinPage(node_->GetPageId(), true);
   }
 
 private:
+  static page_id_t NextLeafPageId(Page *page);
+
   // add your own private member variables here
   KeyType key_;
   bool active_;
@@ -49,6 +52,8 @@ private:
   B_PLUS_TREE_LEAF_PAGE_TYPE *node_;
 	BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  // keeps the next leaves prefetched
+  ReadAhead read_ahead_;
 };
 
 } // namespace cmudb
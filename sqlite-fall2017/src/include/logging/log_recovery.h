@@ -10,6 +10,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "disk/disk_manager.h"
 #include "logging/log_record.h"
 
 namespace cmudb {
@@ -65,6 +65,7 @@ private:
                     BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &pair, int parent_index,
                      BufferPoolManager *buffer_pool_manager);
+  void AdoptChild(page_id_t child_id, BufferPoolManager *buffer_pool_manager);
   MappingType array[0];
 };
 } // namespace cmudb
@@ -0,0 +1,67 @@
+/**
+ * hash_table_bucket_page.h
+ *
+ * Bucket of a disk-resident extendible hash table (see
+ * index/extendible_hash_table.h). Store indexed key and record id together,
+ * in no particular order. Only support unique key.
+ *
+ * A bucket is split when it fills up, until the directory reaches its
+ * largest depth; from then on a full bucket links an overflow bucket through
+ * NextPageId.
+ *
+ * Bucket page format:
+ *  ----------------------------------------------------------------------
+ * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ *  ----------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 20 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | NextPageId (4) |
+ *  ---------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <utility>
+
+#include "page/b_plus_tree_page.h"
+
+namespace cmudb {
+#define HASH_TABLE_BUCKET_PAGE_TYPE                                            \
+  HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class HashTableBucketPage {
+public:
+  // After creating a new bucket page from buffer pool, must call initialize
+  // method to set default values
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+  int GetSize() const;
+  int GetMaxSize() const;
+  inline bool IsFull() const { return GetSize() >= GetMaxSize(); }
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+
+  KeyType KeyAt(int index) const;
+  ValueType ValueAt(int index) const;
+  // index of key, or -1
+  int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
+  bool Lookup(const KeyType &key, ValueType &value,
+              const KeyComparator &comparator) const;
+
+  // append an entry, the bucket must not be full
+  void Insert(const KeyType &key, const ValueType &value);
+  // the last entry takes the place of the removed one
+  void RemoveAt(int index);
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  int size_;
+  int max_size_;
+  page_id_t next_page_id_;
+  MappingType array[0];
+};
+} // namespace cmudb
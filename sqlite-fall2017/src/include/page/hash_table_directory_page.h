@@ -0,0 +1,100 @@
+/**
+ * hash_table_directory_page.h
+ *
+ * Directory of a disk-resident extendible hash table (see
+ * index/extendible_hash_table.h): for every suffix of GlobalDepth hash bits,
+ * a slot with the page id of its bucket and the local depth of that bucket.
+ * A bucket of local depth d is shared by the 2^(GlobalDepth - d) slots that
+ * agree on the last d bits, as in ExtendibleHash.
+ *
+ * The slots live in segment pages of SEGMENT_SLOTS slots each, slot i in
+ * segment i / SEGMENT_SLOTS; the directory page holds the page ids of the
+ * segments. While the directory has no more than SEGMENT_SLOTS slots, only
+ * the first ones of segment 0 are used.
+ *
+ * Directory page format (size in byte):
+ *  --------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | GlobalDepth (4) | SegmentPageId(1) (4) | ... |
+ *  --------------------------------------------------------------------------
+ *
+ * Segment page format (size in byte):
+ *  --------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | LocalDepth(1) (1) | ... | BucketPageId(1) (4) | ... |
+ *  --------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+// largest power of two not above n
+constexpr uint32_t FloorPowerOfTwo(size_t n, uint32_t power = 1) {
+  return 2 * power <= n ? FloorPowerOfTwo(n, 2 * power) : power;
+}
+
+#define SEGMENT_SLOTS FloorPowerOfTwo((PAGE_SIZE - 8) / 5)
+#define DIRECTORY_SEGMENTS FloorPowerOfTwo((PAGE_SIZE - 12) / 4)
+#define DIRECTORY_MAX_SLOTS (SEGMENT_SLOTS * DIRECTORY_SEGMENTS)
+
+class HashTableDirectoryPage {
+public:
+  // After creating a new directory page from buffer pool, must call
+  // initialize method to set default values: global depth 0, one segment
+  void Init(page_id_t page_id, page_id_t segment_page_id);
+
+  page_id_t GetPageId() const;
+
+  uint32_t GetGlobalDepth() const;
+  void IncrGlobalDepth();
+  // the hash bits picking a slot
+  uint32_t GetGlobalDepthMask() const;
+  // number of slots in use
+  uint32_t Size() const;
+  // number of segments in use
+  uint32_t NumSegments() const;
+
+  page_id_t GetSegmentPageId(uint32_t segment) const;
+  void SetSegmentPageId(uint32_t segment, page_id_t segment_page_id);
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t global_depth_;
+  page_id_t segment_page_ids_[DIRECTORY_SEGMENTS];
+};
+
+class HashTableSegmentPage {
+public:
+  // After creating a new segment page from buffer pool, must call initialize
+  // method to set default values
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+
+  // offset: slot index % SEGMENT_SLOTS
+  page_id_t GetBucketPageId(uint32_t offset) const;
+  void SetBucketPageId(uint32_t offset, page_id_t bucket_page_id);
+  uint32_t GetLocalDepth(uint32_t offset) const;
+  void SetLocalDepth(uint32_t offset, uint32_t local_depth);
+
+  // copy count slots from offset from to offset to of this segment, or of
+  // other
+  void CopySlots(uint32_t from, uint32_t to, uint32_t count);
+  void CopySlots(const HashTableSegmentPage *other);
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint8_t local_depths_[SEGMENT_SLOTS];
+  page_id_t bucket_page_ids_[SEGMENT_SLOTS];
+};
+
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE &&
+                  sizeof(HashTableSegmentPage) <= PAGE_SIZE,
+              "the directory must fit in pages");
+
+} // namespace cmudb
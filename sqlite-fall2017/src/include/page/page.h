@@ -8,8 +8,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 #include "common/config.h"
 #include "common/rwmutex.h"
@@ -17,22 +20,60 @@
 namespace cmudb {
 
 class Page {
-  friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
 public:
-  Page() { ResetMemory(); }
-  ~Page(){};
+  // a page owning its memory, or one over a frame of buffer pool memory
+  Page() : data_(new char[PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
+  explicit Page(char *data) : data_(data), owns_data_(false) { ResetMemory(); }
+  ~Page() {
+    if (owns_data_)
+      delete[] data_;
+    delete[] swips_.load();
+  }
+  Page(const Page &) = delete;
+  Page &operator=(const Page &) = delete;
   // get actual data page content
   inline char *GetData() { return data_; }
   // get page id
   inline page_id_t GetPageId() { return page_id_; }
   // get page pin count
   inline int GetPinCount() { return pin_count_; }
+  // number of the frame within its buffer pool, fixed when the frame is made
+  inline size_t GetFrameId() const { return frame_id_; }
   // method use to latch/unlatch page content
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WUnlatch() {
+    EndWrite();
+    rwlatch_.WUnlock();
+  }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    BeginWrite();
+  }
   inline void RUnlatch() { rwlatch_.RUnlock(); }
   inline void RLatch() { rwlatch_.RLock(); }
+  // optimistic read: take the version, read the page without any latch, then
+  // Validate the version. If validation fails a writer changed (or is
+  // changing) the page and what was read must be thrown away. Readers never
+  // write shared memory, so they do not bounce the cache line of hot pages
+  inline uint64_t OptimisticRead() {
+    return version_.load(std::memory_order_acquire);
+  }
+  inline bool Validate(uint64_t version) {
+    // keep the reads of page content before the second version load
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 &&
+           version_.load(std::memory_order_relaxed) == version;
+  }
+
+  // eviction class, see PageClass. Only set it while holding a pin: the
+  // replacer files an unpinned frame under its class
+  inline PageClass GetPageClass() const {
+    return page_class_.load(std::memory_order_relaxed);
+  }
+  inline void SetPageClass(PageClass page_class) {
+    page_class_.store(page_class, std::memory_order_relaxed);
+  }
 
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 4); }
   inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 4, &lsn, 4); }
@@ -40,12 +81,67 @@ public:
 private:
   // method used by buffer pool manager
   inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
+  // version is odd while the page content is being changed, by a writer
+  // holding the write latch or by buffer pool manager loading another page
+  inline void BeginWrite() {
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+  inline void EndWrite() { version_.fetch_add(1, std::memory_order_release); }
+  // pin without buffer pool latch, fails on a frame claimed for reuse.
+  // first: set if the frame was unpinned, it may still be in the replacer
+  inline bool TryPin(bool &first) {
+    int pin_count = pin_count_.load();
+    while (pin_count >= 0)
+      if (pin_count_.compare_exchange_weak(pin_count, pin_count + 1)) {
+        first = pin_count == 0;
+        return true;
+      }
+    return false;
+  }
+  // drop a pin without buffer pool latch. return the pins left, -1 if the
+  // page was not pinned
+  inline int Unpin() {
+    int pin_count = pin_count_.load();
+    while (pin_count > 0)
+      if (pin_count_.compare_exchange_weak(pin_count, pin_count - 1))
+        return pin_count - 1;
+    return -1;
+  }
+  // claim an unpinned frame for reuse (pin count -1), under buffer pool latch.
+  // Fails if it was pinned by TryPin meanwhile
+  inline bool TryClaim() {
+    int unpinned = 0;
+    return pin_count_.compare_exchange_strong(unpinned, -1);
+  }
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
-  bool is_dirty_ = false;
+  char *data_; // actual data
+  bool owns_data_;
+  size_t frame_id_ = 0; // see GetFrameId()
+  // written under buffer pool latch while the frame is claimed, read after
+  // TryPin as well
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  // changed under buffer pool latch, except by TryPin and the undo of a
+  // TryPin on a frame of no page, and by the pin and unpin of a hit with the
+  // CLOCK replacer. -1 while claimed, see TryClaim
+  std::atomic<int> pin_count_{0};
+  // set by an unpin without the latch as well, see UnpinPage()
+  std::atomic<bool> is_dirty_{false};
+  // page content is being read from disk, set under buffer pool latch
+  std::atomic<bool> io_in_progress_{false};
   RWMutex rwlatch_;
+  std::atomic<uint64_t> version_{0}; // see OptimisticRead()
+  std::atomic<PageClass> page_class_{PageClass::DATA};
+  // swizzling, in memory only and written under buffer pool latch, see
+  // BufferPoolManager::FetchChild(). swips_: frames of children fetched
+  // through this page, slot child_id % SWIZZLE_SLOTS, allocated once and read
+  // without the latch. swip_ref_: the slot of a parent holding this frame,
+  // cleared when the frame is evicted
+  std::atomic<std::atomic<Page *> *> swips_{nullptr};
+  std::atomic<Page *> *swip_ref_ = nullptr;
 };
 
+// frame number of a buffer pool frame, see Replacer
+inline size_t FrameOf(Page *page) { return page->GetFrameId(); }
+
 } // namespace cmudb
@@ -7,7 +7,10 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/read_ahead.h"
 #include "common/rid.h"
 #include "table/tuple.h"
 
@@ -19,7 +22,9 @@ class TableIterator {
   friend class Cursor;
 
 public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  // strategy: ring of frames the scan recycles, nullptr for end()
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   ~TableIterator() { delete tuple_; }
 
@@ -43,6 +48,11 @@ private:
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  // a sequential scan reads through its own small ring of frames, so it does
+  // not evict the hot pages of other queries (shared by copies of iterator)
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  // keeps the next pages of the scan prefetched, only set with strategy_
+  std::shared_ptr<ReadAhead> read_ahead_;
 };
 
 } // namespace cmudb
\ No newline at end of file
@@ -5,9 +5,11 @@
 #pragma once
 
 #include "buffer/lru_replacer.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "concurrency/transaction_manager.h"
 #include "index/b_plus_tree_index.h"
+#include "index/hash_table_index.h"
 #include "logging/log_manager.h"
 #include "sqlite/sqlite3ext.h"
 #include "table/table_heap.h"
@@ -59,6 +61,29 @@ int VtabCommit(sqlite3_vtab *pVTab);
 
 int VtabBegin(sqlite3_vtab *pVTab);
 
+/* vtable_stats: read only view of the buffer pool metrics */
+int StatsConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                 sqlite3_vtab **ppVtab, char **pzErr);
+
+int StatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo);
+
+int StatsDisconnect(sqlite3_vtab *pVtab);
+
+int StatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor);
+
+int StatsClose(sqlite3_vtab_cursor *cur);
+
+int StatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                const char *idxStr, int argc, sqlite3_value **argv);
+
+int StatsNext(sqlite3_vtab_cursor *cur);
+
+int StatsEof(sqlite3_vtab_cursor *cur);
+
+int StatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i);
+
+int StatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid);
+
 // storage engine
 class StorageEngine {
 public:
@@ -71,8 +96,16 @@ public:
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
-    buffer_pool_manager_ =
-        new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    // BUFFER_POOL_SIZE frames in all, split over the instances
+    if (BUFFER_POOL_INSTANCES > 1) {
+      buffer_pool_manager_ = new ParallelBufferPoolManager(
+          BUFFER_POOL_INSTANCES, BUFFER_POOL_SIZE / BUFFER_POOL_INSTANCES,
+          disk_manager_, log_manager_);
+      // the remainder of the split goes to the first instances
+      buffer_pool_manager_->Resize(BUFFER_POOL_SIZE);
+    } else
+      buffer_pool_manager_ = new BufferPoolManagerInstance(
+          BUFFER_POOL_SIZE, disk_manager_, log_manager_);
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -257,11 +290,41 @@ private:
   // for index scan
   std::vector<RID> results;
   int offset_ = 0;
-  // for sequential scan
+  // for sequential scan, recycles its own ring of frames (see TableHeap::begin)
   TableIterator table_iterator_;
   // flag to indicate which scan method is currently used
   bool is_index_scan_ = false;
   VirtualTable *virtual_table_;
 }; // namespace cmudb
 
+// one row of vtable_stats
+struct StatsRow {
+  std::string name;
+  int64_t upper_bound_ns; // latency histogram bucket, -1 for plain counters
+  double value;
+};
+
+// cursor of vtable_stats, rows are taken from one metrics snapshot
+class StatsCursor {
+public:
+  // fill rows from the current buffer pool metrics
+  void Load();
+
+  inline bool isEof() { return offset_ == static_cast<int>(rows_.size()); }
+
+  inline const StatsRow &GetCurrentRow() { return rows_[offset_]; }
+
+  inline int GetOffset() { return offset_; }
+
+  StatsCursor &operator++() {
+    ++offset_;
+    return *this;
+  }
+
+private:
+  sqlite3_vtab_cursor base_; /* Base class - must be first */
+  std::vector<StatsRow> rows_;
+  int offset_ = 0;
+};
+
 } // namespace cmudb
\ No newline at end of file
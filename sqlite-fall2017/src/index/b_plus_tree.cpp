@@ -1,6 +1,7 @@
 /**
  * b_plus_tree.cpp
  */
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -48,19 +49,19 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
   //LOG_DEBUG("start");
   LockRootId(TraverseMode::SEARCH);
   bool root_page_id_locked = true;
-  if(IsEmpty())
+  if(IsEmpty()){
+    UnlockRootId(TraverseMode::SEARCH);
     return false;
+  }
   ValueType value;
-  auto page = FindLeafPage(key, TraverseMode::SEARCH, root_page_id_locked);
-  auto leaf_node = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  // the leaf comes back pinned and read latched
+  ReadPageGuard guard(buffer_pool_manager_,
+                      FindLeafPage(key, TraverseMode::SEARCH, root_page_id_locked));
+  auto leaf_node = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(guard.GetData());
   if(leaf_node->Lookup(key, value, comparator_)){
     result.push_back(value);
-    UnLockPage(page, TraverseMode::SEARCH);
-    assert(buffer_pool_manager_->UnpinPage(page->GetPageId(), false));
     return true;
   }
-  UnLockPage(page, TraverseMode::SEARCH);
-  assert(buffer_pool_manager_->UnpinPage(page->GetPageId(), false));
   return false;
 }
 
@@ -97,16 +98,18 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value)
 {
   //LOG_DEBUG("start");
   page_id_t page_id;
-  Page *page;
-  if((page = (buffer_pool_manager_->NewPage(page_id))) == nullptr)
+  PageGuard page =
+      buffer_pool_manager_->NewPageGuarded(page_id, PageClass::INDEX_LEAF);
+  if(!page.IsValid())
     throw Exception("out of memory");
   // crabbing..
   root_page_id_ = page_id;
   UpdateRootPageId(true);
-  B_PLUS_TREE_LEAF_PAGE_TYPE *root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  B_PLUS_TREE_LEAF_PAGE_TYPE *root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page.GetData());
   root->Init(page_id, INVALID_PAGE_ID);
   root->Insert(key, value, comparator_);
-  assert(buffer_pool_manager_->UnpinPage(page_id, true));
+  page.SetDirty();
+  page.Release();
   UnlockRootId(TraverseMode::INSERT);
 }
 
@@ -134,13 +137,13 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
   }
   // deal with split
   if(leaf_node->Insert(key, value, comparator_) > leaf_node->GetMaxSize()){
-    B_PLUS_TREE_LEAF_PAGE_TYPE *new_leaf_node = Split(leaf_node);
+    PageGuard new_page;
+    B_PLUS_TREE_LEAF_PAGE_TYPE *new_leaf_node = Split(leaf_node, new_page);
     KeyType split_key = new_leaf_node->KeyAt(0);
     InsertIntoParent(static_cast<BPlusTreePage *>(leaf_node), 
                      split_key, 
                      static_cast<BPlusTreePage *>(new_leaf_node), 
                      transaction);
-    assert(buffer_pool_manager_->UnpinPage(new_leaf_node->GetPageId(), true));
   }
   UnLockTxnPage(transaction, TraverseMode::INSERT, root_page_id_locked, true);
   return true;
@@ -154,15 +157,17 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * of key & value pairs from input page to newly created page
  */
 INDEX_TEMPLATE_ARGUMENTS
-template <typename N> N *BPLUSTREE_TYPE::Split(N *node) 
+template <typename N> N *BPLUSTREE_TYPE::Split(N *node, PageGuard &new_page) 
 { 
   //LOG_DEBUG("start..");
   page_id_t page_id;
-  Page *page;
-  if((page = (buffer_pool_manager_->NewPage(page_id))) == nullptr)
+  new_page = buffer_pool_manager_->NewPageGuarded(page_id);
+  if(!new_page.IsValid())
     throw Exception("out of memory");
-  N *new_node = reinterpret_cast<N *>(page->GetData());
+  new_page.SetDirty();
+  N *new_node = reinterpret_cast<N *>(new_page.GetData());
   new_node->Init(page_id, node->GetParentPageId());
+  ClassifyPage(new_page.GetPage());
   node->MoveHalfTo(new_node, buffer_pool_manager_);
   return new_node; 
 }
@@ -186,39 +191,41 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
   // deal with depth increase
   if(old_node->IsRootPage()){
     page_id_t page_id;
-    Page *page;
-    if((page = (buffer_pool_manager_->NewPage(page_id))) == nullptr)
+    PageGuard page = buffer_pool_manager_->NewPageGuarded(
+        page_id, PageClass::INDEX_INTERNAL);
+    if(!page.IsValid())
       throw Exception("out of memory");
     root_page_id_ = page_id;
     UpdateRootPageId(false);
     MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *root = 
-      reinterpret_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(page->GetData());
+      reinterpret_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(page.GetData());
     root->Init(page_id, INVALID_PAGE_ID);
     old_node->SetParentPageId(page_id);
     new_node->SetParentPageId(page_id);
     root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
-    assert(buffer_pool_manager_->UnpinPage(page_id, true));
+    page.SetDirty();
     //LOG_DEBUG("depth increase finished");
     return;
   }
   // find the parent page
   auto parent_id = old_node->GetParentPageId();
+  PageGuard parent_page = PageID2Guard(parent_id);
+  parent_page.SetDirty();
   auto parent = reinterpret_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>
-                  (PageID2Node(parent_id));
+                  (parent_page.GetData());
   parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
   // deal with recursive split  
   if(parent->GetSize() > parent->GetMaxSize())
   {
     //LOG_DEBUG("recursive split");
-    MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *new_internal_node = Split(parent);
+    PageGuard new_page;
+    MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *new_internal_node = Split(parent, new_page);
     KeyType split_key = new_internal_node->KeyAt(0);
     InsertIntoParent(static_cast<BPlusTreePage *>(parent), 
                      split_key, 
                      static_cast<BPlusTreePage *>(new_internal_node), 
                      transaction);
-    assert(buffer_pool_manager_->UnpinPage(new_internal_node->GetPageId(), true));;
   }
-  assert(buffer_pool_manager_->UnpinPage(parent->GetPageId(), true));
 }
 
 /*****************************************************************************
@@ -268,8 +275,10 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction)
   }
   page_id_t parent_id, left_sib_id, right_sib_id;  
   parent_id = node->GetParentPageId();
+  PageGuard parent_page = PageID2Guard(parent_id);
+  parent_page.SetDirty();
   auto parent = reinterpret_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>
-                  (PageID2Node(parent_id));
+                  (parent_page.GetData());
   int index = parent->ValueIndex(node->GetPageId());
   N *left_sib, *right_sib;
   Page* page;
@@ -283,7 +292,6 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction)
     if(left_sib->GetSize() + node->GetSize() > node->GetMaxSize()){
       //LOG_DEBUG("redistribute with left sibling");
       Redistribute(left_sib, node, index);
-      assert(buffer_pool_manager_->UnpinPage(parent->GetPageId(), true));
       return false;
     }
   }
@@ -297,7 +305,6 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction)
     if(right_sib->GetSize() + node->GetSize() > node->GetMaxSize()){
       //LOG_DEBUG("redistribute with right sibling");
       Redistribute(right_sib, node, 0);
-      assert(buffer_pool_manager_->UnpinPage(parent->GetPageId(), true));
       return false;
     }
   }
@@ -306,14 +313,12 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction)
   if(index == 0){
     //LOG_DEBUG("coalesce 1");
     ret = Coalesce(right_sib, node, parent, 0, transaction);
-    assert(buffer_pool_manager_->UnpinPage(parent->GetPageId(), true));
     if(ret)
       transaction->AddIntoDeletedPageSet(parent->GetPageId());
     return false;
   }
   //LOG_DEBUG("coalesce 2");
   ret = Coalesce(left_sib, node, parent, index, transaction);
-  assert(buffer_pool_manager_->UnpinPage(parent->GetPageId(), true));
   if(ret)
     transaction->AddIntoDeletedPageSet(parent->GetPageId());
   return true;
@@ -370,16 +375,20 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index)
 {
   //LOG_DEBUG("start..");
   page_id_t parent_id = node->GetParentPageId();
+  PageGuard parent_page = PageID2Guard(parent_id);
+  parent_page.SetDirty();
   auto parent = reinterpret_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>
-                  (PageID2Node(parent_id));
+                  (parent_page.GetData());
   if(index == 0){
+    // the right sibling is not always the second child, node may be any
+    // child that could not borrow from its left sibling
+    int neighbor_index = parent->ValueIndex(neighbor_node->GetPageId());
     neighbor_node->MoveFirstToEndOf(node, buffer_pool_manager_);
-    parent->SetKeyAt(1, neighbor_node->KeyAt(0));
+    parent->SetKeyAt(neighbor_index, neighbor_node->KeyAt(0));
   }else{
     neighbor_node->MoveLastToFrontOf(node, index, buffer_pool_manager_);
     parent->SetKeyAt(index, node->KeyAt(0));
   }
-  assert(buffer_pool_manager_->UnpinPage(parent_id, true));
   //LOG_DEBUG("end..");
 }
 /*
@@ -399,6 +408,11 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
   if(old_root_node->GetSize() == 1 && !(old_root_node->IsLeafPage())){
     root_page_id_ = static_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(old_root_node)
                     ->RemoveAndReturnOnlyChild();
+    // the only child is the root now, its parent is about to be deleted
+    PageGuard new_root = PageID2Guard(root_page_id_);
+    reinterpret_cast<BPlusTreePage *>(new_root.GetData())
+        ->SetParentPageId(INVALID_PAGE_ID);
+    new_root.SetDirty();
     UpdateRootPageId(false);
     return true;
   }
@@ -422,7 +436,7 @@ INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() 
 { 
   //LOG_DEBUG("start..");
-  KeyType *key = reinterpret_cast<KeyType *>(malloc(sizeof(KeyType)));
+  KeyType *key = reinterpret_cast<KeyType *>(calloc(1, sizeof(KeyType)));
   B_PLUS_TREE_LEAF_PAGE_TYPE *node;
   Page *page;
   if((page = traverse(*key, true)) == nullptr){
@@ -455,11 +469,8 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
                               buffer_pool_manager_, 
                               comparator_);
   }else{
-    // fetch page one more time;
-    auto page = buffer_pool_manager_->FetchPage(node->GetPageId());
-    page->WUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(node->GetPageId(), false));
-    assert(buffer_pool_manager_->UnpinPage(node->GetPageId(), false));
+    // traverse left the leaf write latched and pinned
+    WritePageGuard guard(buffer_pool_manager_, page);
     return INDEXITERATOR_TYPE(comparator_);
   }
 }
@@ -513,12 +524,12 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
       page_id = static_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(node)->ValueAt(0);
     else
       page_id = static_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(node)->Lookup(key, comparator_);
-    auto new_page = PageID2Page(page_id);
+    auto new_page = ChildPage(page, page_id);
     node = reinterpret_cast<BPlusTreePage *>(new_page->GetData());
     LockPage(new_page, t_mode);
     if(t_mode == TraverseMode::SEARCH){
       UnLockPage(page, t_mode);
-      assert(buffer_pool_manager_->UnpinPage(page->GetPageId(), false));
+      buffer_pool_manager_->UnpinPage(page, false);
     }
     else{
       if(IsSafe(node, t_mode))
@@ -554,14 +565,14 @@ Page *BPLUSTREE_TYPE::traverse(const KeyType &key, bool left)
       page_id = static_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(node)->ValueAt(0);
     else
       page_id = static_cast<MY_B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(node)->Lookup(key, comparator_);
-    auto new_page = PageID2Page(page_id);
+    auto new_page = ChildPage(page, page_id);
     node = reinterpret_cast<BPlusTreePage *>(new_page->GetData());
     if(node->IsLeafPage())
       new_page->WLatch();
     else
       new_page->RLatch();
     page->RUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(page->GetPageId(), false));
+    buffer_pool_manager_->UnpinPage(page, false);
     page = new_page;
   }
   //LOG_DEBUG("ret");
@@ -579,11 +590,12 @@ Page *BPLUSTREE_TYPE::traverse(const KeyType &key, bool left)
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(
-      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if(header_page == nullptr)
-      throw Exception(EXCEPTION_TYPE_INDEX,
-                      "all page are pinned while printing");
+  PageGuard guard = buffer_pool_manager_->FetchPageGuarded(
+      HEADER_PAGE_ID, nullptr, PageClass::HEADER);
+  if(!guard.IsValid())
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  guard.SetDirty();
+  HeaderPage *header_page = static_cast<HeaderPage *>(guard.GetPage());
   if(root_page_id_ == INVALID_PAGE_ID)
     header_page->DeleteRecord(index_name_);
   else if(insert_record)
@@ -592,7 +604,6 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   else
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -624,7 +635,7 @@ std::string BPLUSTREE_TYPE::ToString(bool verbose) {
         auto child_node = PageID2Node(page_id);
         new_nodes_list->push_back(child_node);
       }
-      assert(buffer_pool_manager_->UnpinPage(node->GetPageId(), false));
+      buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
       //LOG_DEBUG("pnt2");
     }
     temp_nodes_list = old_nodes_list;
@@ -638,7 +649,7 @@ std::string BPLUSTREE_TYPE::ToString(bool verbose) {
     old_nodes_list->pop_front();
     ret_os << static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->ToString(verbose) << std::endl;
     //std::cout << static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->ToString(verbose) << std::endl;
-    assert(buffer_pool_manager_->UnpinPage(node->GetPageId(), false));
+    buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
   }
   return ret_os.str();
 }
@@ -0,0 +1,373 @@
+/**
+ * extendible_hash_table.cpp
+ */
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "index/extendible_hash_table.h"
+#include "page/header_page.h"
+
+namespace cmudb {
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTENDIBLE_HASH_TABLE_TYPE::ExtendibleHashTable(
+    const std::string &name, BufferPoolManager *buffer_pool_manager,
+    const KeyComparator &comparator, page_id_t directory_page_id)
+    : index_name_(name), directory_page_id_(directory_page_id),
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {
+  if(directory_page_id_ != INVALID_PAGE_ID)
+    return;
+  // a new table: the directory, one segment and one bucket
+  page_id_t bucket_page_id, segment_page_id;
+  Page *bucket_page = NewBucketPage(bucket_page_id);
+  Page *segment_page = NewSegmentPage(segment_page_id);
+  SegmentOf(segment_page)->SetBucketPageId(0, bucket_page_id);
+  SegmentOf(segment_page)->SetLocalDepth(0, 0);
+  Page *directory_page = buffer_pool_manager_->NewPage(
+      directory_page_id_, PageClass::INDEX_INTERNAL);
+  if(directory_page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  DirectoryOf(directory_page)->Init(directory_page_id_, segment_page_id);
+  buffer_pool_manager_->UnpinPage(directory_page, true);
+  buffer_pool_manager_->UnpinPage(segment_page, true);
+  buffer_pool_manager_->UnpinPage(bucket_page, true);
+
+  PageGuard guard = buffer_pool_manager_->FetchPageGuarded(
+      HEADER_PAGE_ID, nullptr, PageClass::HEADER);
+  if(!guard.IsValid())
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  guard.SetDirty();
+  static_cast<HeaderPage *>(guard.GetPage())
+      ->InsertRecord(index_name_, directory_page_id_);
+}
+
+/*
+ * FNV-1a over the key bytes, with the high bits folded into the low ones,
+ * which pick the directory slot. Equal keys have equal bytes, GenericKey
+ * clears its data before copying a key in
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::Hash(const KeyType &key) const {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&key);
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for(size_t i = 0; i < sizeof(KeyType); i++){
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *EXTENDIBLE_HASH_TABLE_TYPE::FetchPage(page_id_t page_id,
+                                            PageClass page_class) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id, nullptr, page_class);
+  if(page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *EXTENDIBLE_HASH_TABLE_TYPE::NewBucketPage(page_id_t &page_id) {
+  Page *page = buffer_pool_manager_->NewPage(page_id, PageClass::INDEX_LEAF);
+  if(page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  BucketOf(page)->Init(page_id);
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *EXTENDIBLE_HASH_TABLE_TYPE::NewSegmentPage(page_id_t &page_id) {
+  Page *page = buffer_pool_manager_->NewPage(page_id,
+                                             PageClass::INDEX_INTERNAL);
+  if(page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  SegmentOf(page)->Init(page_id);
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t EXTENDIBLE_HASH_TABLE_TYPE::GetSlot(
+    HashTableDirectoryPage *directory, uint32_t index, uint32_t &local_depth) {
+  Page *segment_page = FetchPage(
+      directory->GetSegmentPageId(index / SEGMENT_SLOTS),
+      PageClass::INDEX_INTERNAL);
+  HashTableSegmentPage *segment = SegmentOf(segment_page);
+  local_depth = segment->GetLocalDepth(index % SEGMENT_SLOTS);
+  page_id_t bucket_page_id = segment->GetBucketPageId(index % SEGMENT_SLOTS);
+  buffer_pool_manager_->UnpinPage(segment_page, false);
+  return bucket_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::CanSplit(HashTableDirectoryPage *directory,
+                                          uint32_t local_depth) {
+  return local_depth < directory->GetGlobalDepth() ||
+         directory->Size() < DIRECTORY_MAX_SLOTS;
+}
+
+/*
+ * A directory within segment 0 copies its slots there, a larger one copies
+ * every segment into a new one
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTENDIBLE_HASH_TABLE_TYPE::DoubleDirectory(
+    HashTableDirectoryPage *directory) {
+  uint32_t size = directory->Size();
+  if(size < SEGMENT_SLOTS){
+    Page *segment_page = FetchPage(directory->GetSegmentPageId(0),
+                                   PageClass::INDEX_INTERNAL);
+    SegmentOf(segment_page)->CopySlots(0, size, size);
+    buffer_pool_manager_->UnpinPage(segment_page, true);
+  } else {
+    uint32_t num_segments = directory->NumSegments();
+    for(uint32_t i = 0; i < num_segments; i++){
+      Page *segment_page = FetchPage(directory->GetSegmentPageId(i),
+                                     PageClass::INDEX_INTERNAL);
+      page_id_t new_page_id;
+      Page *new_page = NewSegmentPage(new_page_id);
+      SegmentOf(new_page)->CopySlots(SegmentOf(segment_page));
+      directory->SetSegmentPageId(num_segments + i, new_page_id);
+      buffer_pool_manager_->UnpinPage(segment_page, false);
+      buffer_pool_manager_->UnpinPage(new_page, true);
+    }
+  }
+  directory->IncrGlobalDepth();
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::GetValue(const KeyType &key,
+                                          std::vector<ValueType> &result,
+                                          Transaction *) {
+  uint32_t hash = Hash(key);
+  Page *directory_page = FetchPage(directory_page_id_,
+                                   PageClass::INDEX_INTERNAL);
+  directory_page->RLatch();
+  HashTableDirectoryPage *directory = DirectoryOf(directory_page);
+  uint32_t local_depth;
+  Page *bucket_page = FetchPage(
+      GetSlot(directory, hash & directory->GetGlobalDepthMask(), local_depth),
+      PageClass::INDEX_LEAF);
+  bucket_page->RLatch();
+  directory_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page, false);
+
+  ValueType value;
+  bool found = BucketOf(bucket_page)->Lookup(key, value, comparator_);
+  page_id_t next_page_id = BucketOf(bucket_page)->GetNextPageId();
+  // overflow buckets are covered by the latch of the first one
+  while(!found && next_page_id != INVALID_PAGE_ID){
+    Page *page = FetchPage(next_page_id, PageClass::INDEX_LEAF);
+    found = BucketOf(page)->Lookup(key, value, comparator_);
+    next_page_id = BucketOf(page)->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page, false);
+  }
+  bucket_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page, false);
+  if(found)
+    result.push_back(value);
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert into the bucket of key under the directory read latch if that
+ * needs no split, otherwise take the directory write latch and split until
+ * the bucket of key has room
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::Insert(const KeyType &key,
+                                        const ValueType &value,
+                                        Transaction *) {
+  uint32_t hash = Hash(key);
+  Page *directory_page = FetchPage(directory_page_id_,
+                                   PageClass::INDEX_INTERNAL);
+  directory_page->RLatch();
+  HashTableDirectoryPage *directory = DirectoryOf(directory_page);
+  uint32_t index = hash & directory->GetGlobalDepthMask();
+  uint32_t local_depth;
+  Page *bucket_page = FetchPage(GetSlot(directory, index, local_depth),
+                                PageClass::INDEX_LEAF);
+  bucket_page->WLatch();
+  bool split = BucketOf(bucket_page)->IsFull() &&
+               BucketOf(bucket_page)->GetNextPageId() == INVALID_PAGE_ID &&
+               CanSplit(directory, local_depth);
+  directory_page->RUnlatch();
+  if(!split){
+    buffer_pool_manager_->UnpinPage(directory_page, false);
+    return InsertIntoChain(bucket_page, key, value);
+  }
+  bucket_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page, false);
+
+  directory_page->WLatch();
+  bool directory_dirty = false;
+  while(true){
+    index = hash & directory->GetGlobalDepthMask();
+    bucket_page = FetchPage(GetSlot(directory, index, local_depth),
+                            PageClass::INDEX_LEAF);
+    bucket_page->WLatch();
+    HASH_TABLE_BUCKET_PAGE_TYPE *bucket = BucketOf(bucket_page);
+    if(!bucket->IsFull() || bucket->GetNextPageId() != INVALID_PAGE_ID ||
+       !CanSplit(directory, local_depth) ||
+       bucket->KeyIndex(key, comparator_) >= 0)
+      break;
+    SplitBucket(directory, index, local_depth, bucket_page);
+    directory_dirty = true;
+    bucket_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page, true);
+  }
+  directory_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page, directory_dirty);
+  return InsertIntoChain(bucket_page, key, value);
+}
+
+/*
+ * Unlatches and unpins bucket_page. A new overflow bucket is linked when
+ * every bucket of the chain is full
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::InsertIntoChain(Page *bucket_page,
+                                                 const KeyType &key,
+                                                 const ValueType &value) {
+  std::vector<Page *> chain = {bucket_page};
+  bool duplicate = false;
+  while(true){
+    HASH_TABLE_BUCKET_PAGE_TYPE *bucket = BucketOf(chain.back());
+    if(bucket->KeyIndex(key, comparator_) >= 0){
+      duplicate = true;
+      break;
+    }
+    if(bucket->GetNextPageId() == INVALID_PAGE_ID)
+      break;
+    chain.push_back(FetchPage(bucket->GetNextPageId(), PageClass::INDEX_LEAF));
+  }
+  Page *dirty_page = nullptr;
+  if(!duplicate){
+    for(Page *page : chain){
+      if(!BucketOf(page)->IsFull()){
+        dirty_page = page;
+        break;
+      }
+    }
+    if(dirty_page == nullptr){
+      page_id_t overflow_page_id;
+      Page *overflow_page = NewBucketPage(overflow_page_id);
+      BucketOf(chain.back())->SetNextPageId(overflow_page_id);
+      buffer_pool_manager_->UnpinPage(chain.back(), true);
+      chain.back() = overflow_page;
+      dirty_page = overflow_page;
+    }
+    BucketOf(dirty_page)->Insert(key, value);
+  }
+  bucket_page->WUnlatch();
+  for(Page *page : chain)
+    buffer_pool_manager_->UnpinPage(page, page == dirty_page);
+  return !duplicate;
+}
+
+/*
+ * Keys with the next hash bit set move to a new bucket, which takes the
+ * directory slots with that bit set. The directory doubles first when the
+ * bucket is as deep as the directory
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTENDIBLE_HASH_TABLE_TYPE::SplitBucket(HashTableDirectoryPage *directory,
+                                             uint32_t index,
+                                             uint32_t local_depth,
+                                             Page *bucket_page) {
+  if(local_depth == directory->GetGlobalDepth())
+    DoubleDirectory(directory);
+  page_id_t new_page_id;
+  Page *new_page = NewBucketPage(new_page_id);
+  HASH_TABLE_BUCKET_PAGE_TYPE *bucket = BucketOf(bucket_page);
+  HASH_TABLE_BUCKET_PAGE_TYPE *new_bucket = BucketOf(new_page);
+  uint32_t split_bit = 1U << local_depth;
+  for(int i = 0; i < bucket->GetSize();){
+    if(Hash(bucket->KeyAt(i)) & split_bit){
+      new_bucket->Insert(bucket->KeyAt(i), bucket->ValueAt(i));
+      bucket->RemoveAt(i);
+    } else {
+      i++;
+    }
+  }
+  // the slots of the bucket, segment by segment
+  Page *segment_page = nullptr;
+  for(uint32_t i = index & (split_bit - 1); i < directory->Size();
+      i += split_bit){
+    if(segment_page == nullptr || i % SEGMENT_SLOTS < split_bit){
+      if(segment_page != nullptr)
+        buffer_pool_manager_->UnpinPage(segment_page, true);
+      segment_page = FetchPage(directory->GetSegmentPageId(i / SEGMENT_SLOTS),
+                               PageClass::INDEX_INTERNAL);
+    }
+    HashTableSegmentPage *segment = SegmentOf(segment_page);
+    segment->SetLocalDepth(i % SEGMENT_SLOTS, local_depth + 1);
+    if(i & split_bit)
+      segment->SetBucketPageId(i % SEGMENT_SLOTS, new_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(segment_page, true);
+  buffer_pool_manager_->UnpinPage(new_page, true);
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::Remove(const KeyType &key, Transaction *) {
+  uint32_t hash = Hash(key);
+  Page *directory_page = FetchPage(directory_page_id_,
+                                   PageClass::INDEX_INTERNAL);
+  directory_page->RLatch();
+  HashTableDirectoryPage *directory = DirectoryOf(directory_page);
+  uint32_t local_depth;
+  Page *bucket_page = FetchPage(
+      GetSlot(directory, hash & directory->GetGlobalDepthMask(), local_depth),
+      PageClass::INDEX_LEAF);
+  bucket_page->WLatch();
+  directory_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page, false);
+
+  bool found = false;
+  Page *page = bucket_page;
+  while(true){
+    HASH_TABLE_BUCKET_PAGE_TYPE *bucket = BucketOf(page);
+    int index = bucket->KeyIndex(key, comparator_);
+    if(index >= 0){
+      bucket->RemoveAt(index);
+      found = true;
+    }
+    page_id_t next_page_id = bucket->GetNextPageId();
+    if(page != bucket_page)
+      buffer_pool_manager_->UnpinPage(page, found);
+    if(found || next_page_id == INVALID_PAGE_ID)
+      break;
+    page = FetchPage(next_page_id, PageClass::INDEX_LEAF);
+  }
+  bucket_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page, found && page == bucket_page);
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::GetGlobalDepth() {
+  Page *directory_page = FetchPage(directory_page_id_,
+                                   PageClass::INDEX_INTERNAL);
+  directory_page->RLatch();
+  uint32_t global_depth = DirectoryOf(directory_page)->GetGlobalDepth();
+  directory_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page, false);
+  return global_depth;
+}
+
+template class ExtendibleHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+
+} // namespace cmudb
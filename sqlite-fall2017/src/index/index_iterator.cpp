@@ -12,7 +12,8 @@ namespace cmudb {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(const KeyComparator &comparator): 
-active_(false), comparator_(comparator){}
+active_(false), comparator_(comparator), 
+read_ahead_(nullptr, &NextLeafPageId, 0){}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *node,
@@ -21,18 +22,30 @@ INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *node,
 																	BufferPoolManager *buffer_pool_manager,
 																	const KeyComparator &comparator):
 key_(key),  active_(true), has_key_(true), index_(index), node_(node), 
-buffer_pool_manager_(buffer_pool_manager), comparator_(comparator){}
+buffer_pool_manager_(buffer_pool_manager), comparator_(comparator),
+read_ahead_(buffer_pool_manager, &NextLeafPageId){
+	read_ahead_.Advance(node_->GetPageId(), node_->GetNextPageId());
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *node,
 																	BufferPoolManager *buffer_pool_manager,
 																	const KeyComparator &comparator):
 active_(true), has_key_(false), index_(0), node_(node), 
-buffer_pool_manager_(buffer_pool_manager), comparator_(comparator){}
+buffer_pool_manager_(buffer_pool_manager), comparator_(comparator),
+read_ahead_(buffer_pool_manager, &NextLeafPageId){
+	read_ahead_.Advance(node_->GetPageId(), node_->GetNextPageId());
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() {}
 
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t INDEXITERATOR_TYPE::NextLeafPageId(Page *page) {
+	return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData())
+			->GetNextPageId();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::isEnd() 
 {
@@ -51,15 +64,18 @@ INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++(){
 	assert(active_);
 	int size = node_->GetSize();
 	////LOG_DEBUG("iterator++ start: index = %d, size = %d\n", index_, size);
-	if(index_ < size - 1)
+	if(index_ < size - 1){
 		index_++;
+		// pick up the leaves whose read completed meanwhile
+		read_ahead_.Poll();
+	}
 	else{
 		page_id_t next_page_id = node_->GetNextPageId();
 		if(next_page_id == INVALID_PAGE_ID){
 			active_ = false;
 			//LOG_DEBUG("iterator to the end: the last leaf node!");
 			UnlockPage();
-			assert(buffer_pool_manager_->UnpinPage(node_->GetPageId(), true));
+			buffer_pool_manager_->UnpinPage(node_->GetPageId(), true);
 			return *this;
 		}
 		else{
@@ -67,9 +83,12 @@ INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++(){
 			auto page = buffer_pool_manager_->FetchPage(next_page_id);
 			page->WLatch();
 			UnlockPage();
-			assert(buffer_pool_manager_->UnpinPage(node_->GetPageId(), true));
+			buffer_pool_manager_->UnpinPage(node_->GetPageId(), true);
 			node_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
 			index_ = 0;	
+			// the previous leaf is unlatched. Read ahead never waits, for I/O or
+			// a latch, so it doesn't hold up writers of the leaf latched now
+			read_ahead_.Advance(node_->GetPageId(), node_->GetNextPageId());
 		}
 	}
 	return *this;
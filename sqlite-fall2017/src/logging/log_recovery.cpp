@@ -19,7 +19,7 @@ bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord &log_record)
   if(data + 20 > log_buffer_ + LOG_BUFFER_SIZE){
     return false;
   }
-  memcpy(&log_record, data, 20);
+  memcpy(static_cast<void *>(&log_record), data, 20);
   pos += 20;
   // incomplete record
   if(data + log_record.size_ > log_buffer_ + LOG_BUFFER_SIZE){
@@ -157,13 +157,13 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
   for(; size > 0; size--, items++, i++){
     array[i].first = items->first;
     array[i].second = items->second;
-    auto *page = buffer_pool_manager->FetchPage(items->second);
-    if (page == nullptr)
+    PageGuard page = buffer_pool_manager->FetchPageGuarded(items->second);
+    if (!page.IsValid())
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while printing");
-    BPlusTreePage *node = reinterpret_cast<BPlusTreePage*>(page->GetData());
+    BPlusTreePage *node = reinterpret_cast<BPlusTreePage*>(page.GetData());
     node->SetParentPageId(GetPageId());
-    assert(buffer_pool_manager->UnpinPage(items->second, true));
+    page.SetDirty();
   }
 }
 
@@ -211,6 +211,14 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
     BufferPoolManager *buffer_pool_manager) 
 {
   // logic moved in tree: remove the node from parent node
+  // the separator in the parent becomes the key of the first child
+  PageGuard parent_page =
+      buffer_pool_manager->FetchPageGuarded(GetParentPageId());
+  if (!parent_page.IsValid())
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  auto parent =
+      reinterpret_cast<BPlusTreeInternalPage *>(parent_page.GetData());
+  SetKeyAt(0, parent->KeyAt(index_in_parent));
   recipient->CopyAllFrom(&array[0], GetSize(), buffer_pool_manager);
   SetSize(0);
 }
@@ -224,13 +232,13 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
   for(; size > 0; size--, items++, i++){
     array[i].first = items->first;
     array[i].second = items->second;
-    auto *page = buffer_pool_manager->FetchPage(items->second);
-    if (page == nullptr)
+    PageGuard page = buffer_pool_manager->FetchPageGuarded(items->second);
+    if (!page.IsValid())
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while printing");
-    BPlusTreePage *node = reinterpret_cast<BPlusTreePage*>(page->GetData());
-    node->SetParentPageId(items->second);
-    assert(buffer_pool_manager->UnpinPage(node->GetPageId(), true));
+    BPlusTreePage *node = reinterpret_cast<BPlusTreePage*>(page.GetData());
+    node->SetParentPageId(GetPageId());
+    page.SetDirty();
   }
 }
 
@@ -247,6 +255,14 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
     BufferPoolManager *buffer_pool_manager) 
 {
   int index, size;
+  // the separator in the parent goes down with the first child
+  PageGuard parent_page =
+      buffer_pool_manager->FetchPageGuarded(GetParentPageId());
+  if (!parent_page.IsValid())
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  auto parent =
+      reinterpret_cast<BPlusTreeInternalPage *>(parent_page.GetData());
+  SetKeyAt(0, parent->KeyAt(parent->ValueIndex(GetPageId())));
   recipient->CopyLastFrom(array[0], buffer_pool_manager);
   for(size = GetSize(), index = 0; index < GetSize() - 1; index++){
     array[index].first = array[index + 1].first;
@@ -263,6 +279,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(
   array[size].first = pair.first;
   array[size].second = pair.second;
   IncreaseSize(1);
+  AdoptChild(pair.second, buffer_pool_manager);
 }
 
 /*
@@ -284,14 +301,37 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
     const MappingType &pair, int parent_index,
     BufferPoolManager *buffer_pool_manager) 
 {
+  // the separator in the parent goes down with the old first child
+  PageGuard parent_page =
+      buffer_pool_manager->FetchPageGuarded(GetParentPageId());
+  if (!parent_page.IsValid())
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  auto parent =
+      reinterpret_cast<BPlusTreeInternalPage *>(parent_page.GetData());
+  SetKeyAt(0, parent->KeyAt(parent_index));
   int index;
-  for(index = GetSize() - 1; index != 0; index--){
-    array[index + 1].first = array[index].first;
-    array[index + 1].second = array[index].second;
+  for(index = GetSize(); index != 0; index--){
+    array[index].first = array[index - 1].first;
+    array[index].second = array[index - 1].second;
   }
-  array[index + 1].first = pair.first;
-  array[index + 1].second = pair.second;
+  array[0].first = pair.first;
+  array[0].second = pair.second;
   IncreaseSize(1);
+  AdoptChild(pair.second, buffer_pool_manager);
+}
+
+/*
+ * Point the parent id of child, just moved into this page, at this page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::AdoptChild(
+    page_id_t child_id, BufferPoolManager *buffer_pool_manager) {
+  PageGuard page = buffer_pool_manager->FetchPageGuarded(child_id);
+  if (!page.IsValid())
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  reinterpret_cast<BPlusTreePage *>(page.GetData())
+      ->SetParentPageId(GetPageId());
+  page.SetDirty();
 }
 
 /*****************************************************************************
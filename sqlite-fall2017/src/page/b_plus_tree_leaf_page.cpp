@@ -273,13 +273,12 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(
     BufferPoolManager *buffer_pool_manager) 
 {
   int index;
-  for(index = GetSize() - 1; index != 0; index--){
-    array[index + 1].first = array[index].first;
-    array[index + 1].second = array[index].second;
+  for(index = GetSize(); index != 0; index--){
+    array[index].first = array[index - 1].first;
+    array[index].second = array[index - 1].second;
   }
-  assert(index == 0);
-  array[index + 1].first = items.first;
-  array[index + 1].second = items.second;
+  array[0].first = items.first;
+  array[0].second = items.second;
   IncreaseSize(1);
 }
 
@@ -0,0 +1,101 @@
+/**
+ * hash_table_directory_page.cpp
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+/*****************************************************************************
+ * DIRECTORY
+ *****************************************************************************/
+void HashTableDirectoryPage::Init(page_id_t page_id,
+                                  page_id_t segment_page_id) {
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  global_depth_ = 0;
+  segment_page_ids_[0] = segment_page_id;
+}
+
+page_id_t HashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+uint32_t HashTableDirectoryPage::GetGlobalDepth() const {
+  return global_depth_;
+}
+
+void HashTableDirectoryPage::IncrGlobalDepth() {
+  assert(Size() < DIRECTORY_MAX_SLOTS);
+  global_depth_++;
+}
+
+uint32_t HashTableDirectoryPage::GetGlobalDepthMask() const {
+  return Size() - 1;
+}
+
+uint32_t HashTableDirectoryPage::Size() const { return 1U << global_depth_; }
+
+uint32_t HashTableDirectoryPage::NumSegments() const {
+  return (Size() + SEGMENT_SLOTS - 1) / SEGMENT_SLOTS;
+}
+
+page_id_t HashTableDirectoryPage::GetSegmentPageId(uint32_t segment) const {
+  assert(segment < DIRECTORY_SEGMENTS);
+  return segment_page_ids_[segment];
+}
+
+void HashTableDirectoryPage::SetSegmentPageId(uint32_t segment,
+                                              page_id_t segment_page_id) {
+  assert(segment < DIRECTORY_SEGMENTS);
+  segment_page_ids_[segment] = segment_page_id;
+}
+
+/*****************************************************************************
+ * SEGMENT
+ *****************************************************************************/
+void HashTableSegmentPage::Init(page_id_t page_id) {
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+}
+
+page_id_t HashTableSegmentPage::GetPageId() const { return page_id_; }
+
+page_id_t HashTableSegmentPage::GetBucketPageId(uint32_t offset) const {
+  assert(offset < SEGMENT_SLOTS);
+  return bucket_page_ids_[offset];
+}
+
+void HashTableSegmentPage::SetBucketPageId(uint32_t offset,
+                                           page_id_t bucket_page_id) {
+  assert(offset < SEGMENT_SLOTS);
+  bucket_page_ids_[offset] = bucket_page_id;
+}
+
+uint32_t HashTableSegmentPage::GetLocalDepth(uint32_t offset) const {
+  assert(offset < SEGMENT_SLOTS);
+  return local_depths_[offset];
+}
+
+void HashTableSegmentPage::SetLocalDepth(uint32_t offset,
+                                         uint32_t local_depth) {
+  assert(offset < SEGMENT_SLOTS);
+  local_depths_[offset] = local_depth;
+}
+
+void HashTableSegmentPage::CopySlots(uint32_t from, uint32_t to,
+                                     uint32_t count) {
+  assert(from + count <= SEGMENT_SLOTS && to + count <= SEGMENT_SLOTS);
+  memmove(local_depths_ + to, local_depths_ + from, count);
+  memmove(bucket_page_ids_ + to, bucket_page_ids_ + from,
+          count * sizeof(page_id_t));
+}
+
+void HashTableSegmentPage::CopySlots(const HashTableSegmentPage *other) {
+  memcpy(local_depths_, other->local_depths_, sizeof(local_depths_));
+  memcpy(bucket_page_ids_, other->bucket_page_ids_,
+         sizeof(bucket_page_ids_));
+}
+
+} // namespace cmudb
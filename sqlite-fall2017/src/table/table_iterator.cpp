@@ -3,15 +3,36 @@
  */
 
 #include <cassert>
+#include <utility>
 
 #include "table/table_heap.h"
 
 namespace cmudb {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+static page_id_t NextTablePageId(Page *page) {
+  return static_cast<TablePage *>(page)->GetNextPageId();
+}
+
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn),
+      strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_, strategy_.get());
+  }
+  if (strategy_ != nullptr && rid.GetPageId() != INVALID_PAGE_ID) {
+    BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+    read_ahead_ = std::make_shared<ReadAhead>(
+        buffer_pool_manager, &NextTablePageId, READ_AHEAD_WINDOW,
+        strategy_.get());
+    ReadPageGuard guard =
+        buffer_pool_manager->FetchPageRead(rid.GetPageId(), strategy_.get());
+    if (guard.IsValid()) {
+      page_id_t next_page_id =
+          static_cast<TablePage *>(guard.GetPage())->GetNextPageId();
+      guard.Release();
+      read_ahead_->Advance(rid.GetPageId(), next_page_id);
+    }
   }
 };
 
@@ -27,21 +48,20 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr); // all pages are pinned
+  page_id_t old_page_id = tuple_->rid_.GetPageId();
+  ReadPageGuard guard = buffer_pool_manager->FetchPageRead(
+      tuple_->rid_.GetPageId(), strategy_.get());
+  assert(guard.IsValid()); // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  next_tuple_rid)) { // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(
-          buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      ReadPageGuard next_guard = buffer_pool_manager->FetchPageRead(
+          cur_page->GetNextPageId(), strategy_.get());
+      guard = std::move(next_guard);
+      cur_page = static_cast<TablePage *>(guard.GetPage());
       if (cur_page->GetFirstTupleRid(next_tuple_rid))
         break;
     }
@@ -49,11 +69,17 @@ TableIterator &TableIterator::operator++() {
   tuple_->rid_ = next_tuple_rid;
 
   if (*this != table_heap_->end()) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_, strategy_.get());
   }
+  page_id_t cur_page_id = cur_page->GetPageId();
+  page_id_t next_page_id = cur_page->GetNextPageId();
   // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
+  guard.Release();
+  // crossed a page boundary, keep the pages ahead in flight
+  if (read_ahead_ != nullptr && cur_page_id != old_page_id)
+    read_ahead_->Advance(cur_page_id, next_page_id);
+  else if (read_ahead_ != nullptr)
+    read_ahead_->Poll();
   return *this;
 }
 
@@ -27,7 +27,8 @@ int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
 
   // fetch header page from buffer pool
   HeaderPage *header_page =
-      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(
+          HEADER_PAGE_ID, nullptr, PageClass::HEADER));
 
   // the first three parameter:(1) module name (2) database name (3)table name
   assert(argc >= 4);
@@ -78,7 +79,8 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
 
   // Retrieve table root page info from header page
   HeaderPage *header_page =
-      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(
+          HEADER_PAGE_ID, nullptr, PageClass::HEADER));
   page_id_t table_root_id;
   header_page->GetRootId(std::string(argv[2]), table_root_id);
   // parse arg[4](string that defines table index)
@@ -153,6 +155,7 @@ int VtabDisconnect(sqlite3_vtab *pVtab) {
   delete virtual_table;
   // delete all the global managers
   delete storage_engine_;
+  storage_engine_ = nullptr;
   return SQLITE_OK;
 }
 
@@ -348,6 +351,145 @@ sqlite3_module VtableModule = {
     0,              /* xRollbackTo */
 };
 
+/*
+ * vtable_stats is eponymous (no xCreate), query it directly:
+ *   SELECT * FROM vtable_stats;
+ * name: counter name, upper_bound_ns: exclusive upper bound of a latency
+ * histogram bucket (NULL for plain counters), value: counter value
+ */
+int StatsConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                 sqlite3_vtab **ppVtab, char **pzErr) {
+  int rc = sqlite3_declare_vtab(
+      db, "CREATE TABLE X(name VARCHAR, upper_bound_ns BIGINT, value NUMERIC);");
+  if (rc != SQLITE_OK)
+    return rc;
+  sqlite3_vtab *vtab = new sqlite3_vtab();
+  *ppVtab = vtab;
+  return SQLITE_OK;
+}
+
+int StatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
+  // always a full scan over a few rows
+  pIdxInfo->estimatedCost = 100;
+  return SQLITE_OK;
+}
+
+int StatsDisconnect(sqlite3_vtab *pVtab) {
+  delete pVtab;
+  return SQLITE_OK;
+}
+
+int StatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  StatsCursor *cursor = new StatsCursor();
+  *ppCursor = reinterpret_cast<sqlite3_vtab_cursor *>(cursor);
+  return SQLITE_OK;
+}
+
+int StatsClose(sqlite3_vtab_cursor *cur) {
+  delete reinterpret_cast<StatsCursor *>(cur);
+  return SQLITE_OK;
+}
+
+int StatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                const char *idxStr, int argc, sqlite3_value **argv) {
+  reinterpret_cast<StatsCursor *>(pVtabCursor)->Load();
+  return SQLITE_OK;
+}
+
+int StatsNext(sqlite3_vtab_cursor *cur) {
+  ++(*reinterpret_cast<StatsCursor *>(cur));
+  return SQLITE_OK;
+}
+
+int StatsEof(sqlite3_vtab_cursor *cur) {
+  return reinterpret_cast<StatsCursor *>(cur)->isEof();
+}
+
+int StatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  const StatsRow &row = reinterpret_cast<StatsCursor *>(cur)->GetCurrentRow();
+  switch (i) {
+  case 0:
+    sqlite3_result_text(ctx, row.name.c_str(), -1, SQLITE_TRANSIENT);
+    break;
+  case 1:
+    if (row.upper_bound_ns < 0)
+      sqlite3_result_null(ctx);
+    else
+      sqlite3_result_int64(ctx, row.upper_bound_ns);
+    break;
+  case 2:
+    if (row.value == static_cast<sqlite3_int64>(row.value))
+      sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(row.value));
+    else
+      sqlite3_result_double(ctx, row.value);
+    break;
+  default:
+    return SQLITE_ERROR;
+  }
+  return SQLITE_OK;
+}
+
+int StatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
+  *pRowid = reinterpret_cast<StatsCursor *>(cur)->GetOffset();
+  return SQLITE_OK;
+}
+
+void StatsCursor::Load() {
+  rows_.clear();
+  offset_ = 0;
+  // the storage engine is gone once the last vtable disconnected
+  if (storage_engine_ == nullptr)
+    return;
+  BufferPoolMetricsSnapshot metrics =
+      storage_engine_->buffer_pool_manager_->GetMetrics();
+  rows_.push_back({"hits", -1, static_cast<double>(metrics.hits)});
+  rows_.push_back({"misses", -1, static_cast<double>(metrics.misses)});
+  rows_.push_back({"hit_ratio", -1, metrics.HitRatio()});
+  rows_.push_back({"evictions", -1, static_cast<double>(metrics.evictions)});
+  rows_.push_back({"foreground_writes", -1,
+                   static_cast<double>(metrics.foreground_writes)});
+  rows_.push_back({"background_writes", -1,
+                   static_cast<double>(metrics.background_writes)});
+  rows_.push_back(
+      {"frame_wait_ns", -1, static_cast<double>(metrics.frame_wait_ns)});
+  // only the non empty latency buckets
+  for (int i = 0; i < METRICS_LATENCY_BUCKETS; ++i) {
+    int64_t bound = BufferPoolMetricsSnapshot::BucketUpperBound(i);
+    if (metrics.hit_latency[i] > 0)
+      rows_.push_back({"hit_latency_ns", bound,
+                       static_cast<double>(metrics.hit_latency[i])});
+    if (metrics.miss_latency[i] > 0)
+      rows_.push_back({"miss_latency_ns", bound,
+                       static_cast<double>(metrics.miss_latency[i])});
+  }
+}
+
+sqlite3_module StatsModule = {
+    0,               /* iVersion */
+    0,               /* xCreate - eponymous only */
+    StatsConnect,    /* xConnect */
+    StatsBestIndex,  /* xBestIndex */
+    StatsDisconnect, /* xDisconnect */
+    StatsDisconnect, /* xDestroy */
+    StatsOpen,       /* xOpen - open a cursor */
+    StatsClose,      /* xClose - close a cursor */
+    StatsFilter,     /* xFilter - configure scan constraints */
+    StatsNext,       /* xNext - advance a cursor */
+    StatsEof,        /* xEof - check for end of scan */
+    StatsColumn,     /* xColumn - read data */
+    StatsRowid,      /* xRowid - read data */
+    0,               /* xUpdate - read only */
+    0,               /* xBegin */
+    0,               /* xSync */
+    0,               /* xCommit */
+    0,               /* xRollback */
+    0,               /* xFindMethod */
+    0,               /* xRename */
+    0,               /* xSavepoint */
+    0,               /* xRelease */
+    0,               /* xRollbackTo */
+};
+
 #ifdef _WIN32
 __declspec(dllexport)
 #endif
@@ -365,13 +507,17 @@ __declspec(dllexport)
   // create header page from BufferPoolManager if necessary
   if (!is_file_exist) {
     page_id_t header_page_id;
-    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
+    storage_engine_->buffer_pool_manager_->NewPage(header_page_id,
+                                                   PageClass::HEADER);
 
     assert(header_page_id == HEADER_PAGE_ID);
     storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
   }
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  if (rc != SQLITE_OK)
+    return rc;
+  rc = sqlite3_create_module(db, "vtable_stats", &StatsModule, nullptr);
   return rc;
 }
 
@@ -445,6 +591,19 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   int column_id = -1;
   // prepocess, transform sql string into lower case
   std::transform(sql.begin(), sql.end(), sql.begin(), ::tolower);
+  // optional index structure: "index_name a, b using hash"
+  IndexType index_type = IndexType::BPLUS_TREE;
+  n = sql.rfind(" using ");
+  if (n != std::string::npos) {
+    std::string type_name = sql.substr(n + 7);
+    StringUtility::Trim(type_name);
+    if (type_name == "hash")
+      index_type = IndexType::HASH;
+    else if (type_name != "btree")
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, unknown type " + type_name);
+    sql = sql.substr(0, n);
+  }
   n = sql.find_first_of(' ');
   // NOTE: must use whitespace to seperate index name and indexed column names
   assert(n != std::string::npos);
@@ -462,8 +621,8 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   if ((int)key_attrs.size() > schema->GetColumnCount())
     throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, format error");
 
-  IndexMetadata *metadata =
-      new IndexMetadata(index_name, table_name, schema, key_attrs);
+  IndexMetadata *metadata = new IndexMetadata(index_name, table_name, schema,
+                                              key_attrs, index_type);
 
   // LOG_DEBUG("%s", metadata->ToString().c_str());
   return metadata;
@@ -504,7 +663,22 @@ Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
   return tuple;
 }
 
+// the index of metadata's type for keys of KeySize bytes
+template <size_t KeySize>
+static Index *ConstructSizedIndex(IndexMetadata *metadata,
+                                  BufferPoolManager *buffer_pool_manager,
+                                  page_id_t root_id) {
+  if (metadata->GetIndexType() == IndexType::HASH)
+    return new HashTableIndex<GenericKey<KeySize>, RID,
+                              GenericComparator<KeySize>>(
+        metadata, buffer_pool_manager, root_id);
+  return new BPlusTreeIndex<GenericKey<KeySize>, RID,
+                            GenericComparator<KeySize>>(
+      metadata, buffer_pool_manager, root_id);
+}
+
 // serve the functionality of index factory
+// root_id: the root page of a b+ tree, the directory page of a hash index
 Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
                       page_id_t root_id) {
@@ -514,22 +688,16 @@ Index *ConstructIndex(IndexMetadata *metadata,
   // for each varchar attribute, we assume the largest size is 16 bytes
   key_size += 16 * key_schema->GetUnlinedColumnCount();
 
-  if (key_size <= 4) {
-    return new BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>(
-        metadata, buffer_pool_manager, root_id);
-  } else if (key_size <= 8) {
-    return new BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>(
-        metadata, buffer_pool_manager, root_id);
-  } else if (key_size <= 16) {
-    return new BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>(
-        metadata, buffer_pool_manager, root_id);
-  } else if (key_size <= 32) {
-    return new BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>(
-        metadata, buffer_pool_manager, root_id);
-  } else {
-    return new BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>(
-        metadata, buffer_pool_manager, root_id);
-  }
+  if (key_size <= 4)
+    return ConstructSizedIndex<4>(metadata, buffer_pool_manager, root_id);
+  else if (key_size <= 8)
+    return ConstructSizedIndex<8>(metadata, buffer_pool_manager, root_id);
+  else if (key_size <= 16)
+    return ConstructSizedIndex<16>(metadata, buffer_pool_manager, root_id);
+  else if (key_size <= 32)
+    return ConstructSizedIndex<32>(metadata, buffer_pool_manager, root_id);
+  else
+    return ConstructSizedIndex<64>(metadata, buffer_pool_manager, root_id);
 }
 
 Transaction *GetTransaction() { return global_transaction_; }
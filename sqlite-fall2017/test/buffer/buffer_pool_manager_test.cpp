@@ -2,9 +2,19 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 
 namespace cmudb {
@@ -13,7 +23,7 @@ TEST(BufferPoolManagerTest, SampleTest) {
   page_id_t temp_page_id;
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager bpm(10, disk_manager);
+  BufferPoolManagerInstance bpm(10, disk_manager);
 
   auto page_zero = bpm.NewPage(temp_page_id);
   EXPECT_NE(nullptr, page_zero);
@@ -48,4 +58,982 @@ TEST(BufferPoolManagerTest, SampleTest) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, LinearPageTableTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(10, disk_manager, nullptr, ReplacerType::LRU,
+                                HashTableType::LINEAR);
+  // write 50 pages through 10 frames, then read them back
+  for (int i = 0; i < 50; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", temp_page_id);
+    EXPECT_TRUE(bpm.UnpinPage(temp_page_id, true));
+  }
+  char expected[16];
+  for (int i = 0; i < 50; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, sizeof(expected), "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_TRUE(bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ClockReplacerTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(10, disk_manager, nullptr, ReplacerType::CLOCK);
+
+  auto page_zero = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, temp_page_id);
+  strcpy(page_zero->GetData(), "Hello");
+
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  // all the pages are pinned, the buffer pool is full
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  // unpin the first five pages, set as dirty
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  // five frames can be reclaimed, the sixth request fails
+  for (int i = 10; i < 15; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  // free one frame and read page zero back from disk
+  EXPECT_EQ(true, bpm.UnpinPage(14, false));
+  page_zero = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, AccessStrategyTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(10, disk_manager);
+
+  // pages 0 - 19 are written to disk, they will be scanned later
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // pages 20 - 24 are hot and only live in memory (never flushed), they would
+  // read back as zeros if they got evicted
+  for (int i = 20; i < 25; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    strcpy(page->GetData(), "hot");
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+
+  // a sequential scan over 20 pages through a ring of 4 frames
+  BufferAccessStrategy strategy;
+  EXPECT_EQ(static_cast<size_t>(RING_BUFFER_SIZE), strategy.GetRingSize());
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm.FetchPage(i, &strategy);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // the hot pages survived the scan
+  for (int i = 20; i < 25; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), "hot"));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+  const int num_threads = 8;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(10, disk_manager);
+
+  // pages 0 - 4 are written to disk, then pushed out of the pool
+  for (int i = 0; i < 15; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // every thread misses on the same pages at the same time, each page is
+  // still read from disk only once
+  int num_reads = disk_manager->GetNumReads();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.push_back(std::thread([&bpm]() {
+      char expected[PAGE_SIZE];
+      for (int i = 0; i < 5; ++i) {
+        auto page = bpm.FetchPage(i);
+        EXPECT_NE(nullptr, page);
+        if (page == nullptr)
+          continue;
+        snprintf(expected, PAGE_SIZE, "page %d", i);
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        EXPECT_EQ(true, bpm.UnpinPage(i, false));
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(num_reads + 5, disk_manager->GetNumReads());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// with CLOCK, hits pin and unpin without the latch while other threads miss
+// and evict: every page read is the right one, and no frame is lost from the
+// replacer on the way
+TEST(BufferPoolManagerTest, ClockConcurrentHitTest) {
+  const int num_threads = 4;
+  const int num_pages = 16;
+  const int pool_size = 8;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(pool_size, disk_manager, nullptr,
+                                ReplacerType::CLOCK);
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.push_back(std::thread([&bpm, t]() {
+      std::mt19937 gen(t);
+      // a hot page most of the time, so hits and misses mix
+      std::uniform_int_distribution<int> hot(0, 3);
+      std::uniform_int_distribution<int> any(0, num_pages - 1);
+      char expected[PAGE_SIZE];
+      for (int i = 0; i < 2000; ++i) {
+        page_id_t page_id = i % 4 == 0 ? any(gen) : hot(gen);
+        auto page = bpm.FetchPage(page_id);
+        if (page == nullptr)
+          continue;
+        snprintf(expected, PAGE_SIZE, "page %d", page_id);
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        if (i % 2 == 0) {
+          EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+        } else {
+          EXPECT_EQ(true, bpm.UnpinPage(page, false));
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  // every frame is unpinned and can be taken for a new page
+  for (int i = 0; i < pool_size; ++i)
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(10, disk_manager);
+
+  // fill the pool with dirty unpinned pages, page 0 is the coldest
+  for (int i = 0; i < 10; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // the cleaner writes back the five coldest pages ahead of demand
+  bpm.StartCleaner(5, 1000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10 * CLEANER_INTERVAL));
+  bpm.StopCleaner();
+  EXPECT_EQ(5u, bpm.GetBackgroundWrites());
+
+  // evicting them needs no write on the foreground path
+  for (int i = 10; i < 15; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  EXPECT_EQ(0u, bpm.GetForegroundWrites());
+
+  // the written pages read back intact, a dirty page still gets written on
+  // eviction
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 5; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(5u, bpm.GetForegroundWrites());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(10, disk_manager);
+
+  // pages 0 - 4 are written to disk, then pushed out of the pool
+  for (int i = 0; i < 15; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  int num_reads = disk_manager->GetNumReads();
+  // only resident pages are pinned without a read
+  EXPECT_EQ(nullptr, bpm.FetchPageIfResident(0));
+  auto resident = bpm.FetchPageIfResident(14);
+  ASSERT_NE(nullptr, resident);
+  EXPECT_EQ(1, resident->GetPinCount());
+  EXPECT_EQ(true, bpm.UnpinPage(14, false));
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+
+  for (int i = 0; i < 5; ++i)
+    bpm.Prefetch(i);
+  // prefetching a resident page does nothing
+  bpm.Prefetch(14);
+
+  // prefetched pages are not pinned, fetching them does not read again
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 5; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    EXPECT_EQ(false, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(num_reads + 5, disk_manager->GetNumReads());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, MetricsTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(10, disk_manager);
+
+  // 15 new pages in 10 frames: 5 dirty evictions
+  for (int i = 0; i < 15; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // pages 10 - 14 are resident, pages 0 - 2 are read back from disk
+  for (int i = 10; i < 15; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  BufferPoolMetricsSnapshot metrics = bpm.GetMetrics();
+  EXPECT_EQ(5u, metrics.hits);
+  EXPECT_EQ(3u, metrics.misses);
+  EXPECT_EQ(8u, metrics.evictions);
+  EXPECT_EQ(8u, metrics.foreground_writes);
+  EXPECT_EQ(0u, metrics.background_writes);
+  EXPECT_DOUBLE_EQ(5.0 / 8, metrics.HitRatio());
+  uint64_t hit_latencies = 0, miss_latencies = 0;
+  for (int i = 0; i < METRICS_LATENCY_BUCKETS; ++i) {
+    hit_latencies += metrics.hit_latency[i];
+    miss_latencies += metrics.miss_latency[i];
+  }
+  EXPECT_EQ(metrics.hits, hit_latencies);
+  EXPECT_EQ(metrics.misses, miss_latencies);
+
+  // recorded from another thread, added up in the next snapshot
+  std::thread([&bpm]() {
+    ASSERT_NE(nullptr, bpm.FetchPage(0));
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  }).join();
+  EXPECT_EQ(6u, bpm.GetMetrics().hits);
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PageGuardTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(3, disk_manager);
+
+  {
+    PageGuard guard = bpm.NewPageGuarded(temp_page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(0, temp_page_id);
+    strcpy(guard.GetData(), "Hello");
+    guard.SetDirty();
+    // the pin moves along with the guard
+    PageGuard moved = std::move(guard);
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(1, moved.GetPage()->GetPinCount());
+  }
+  {
+    ReadPageGuard first = bpm.FetchPageRead(0);
+    ReadPageGuard second = bpm.FetchPageRead(0);
+    EXPECT_EQ(2, first.GetPage()->GetPinCount());
+    EXPECT_EQ(0, strcmp(first.GetData(), "Hello"));
+    second.Release();
+    EXPECT_EQ(1, first.GetPage()->GetPinCount());
+  }
+  {
+    // the read latches are gone, so is the pin
+    WritePageGuard guard = bpm.FetchPageWrite(0);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+  }
+
+  // evict page 0, it was unpinned dirty so it is read back intact
+  for (int i = 1; i < 4; ++i) {
+    EXPECT_TRUE(bpm.NewPageGuarded(temp_page_id).IsValid());
+  }
+  {
+    std::vector<PageGuard> guards;
+    for (int i = 0; i < 3; ++i) {
+      guards.push_back(bpm.FetchPageGuarded(i));
+      ASSERT_TRUE(guards.back().IsValid());
+    }
+    EXPECT_EQ(0, strcmp(guards[0].GetData(), "Hello"));
+    // all the frames are pinned
+    EXPECT_FALSE(bpm.FetchPageGuarded(3).IsValid());
+  }
+
+  // unpin by frame
+  Page *page = bpm.FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  EXPECT_EQ(false, bpm.UnpinPage(page, false));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, FetchPagesTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(3, disk_manager);
+
+  for (int i = 0; i < 6; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // 3 - 5 are resident: two hits, a miss given twice and a miss that finds
+  // every frame pinned
+  page_id_t page_ids[] = {4, 1, 5, 1, 0};
+  Page *pages[5];
+  EXPECT_EQ(4u, bpm.FetchPages(page_ids, 5, pages));
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ(page_ids[i], *reinterpret_cast<page_id_t *>(pages[i]->GetData()));
+  }
+  EXPECT_EQ(pages[1], pages[3]);
+  EXPECT_EQ(2, pages[1]->GetPinCount());
+  // no frame left for page 0
+  EXPECT_EQ(nullptr, pages[4]);
+  EXPECT_EQ(1u, bpm.GetMetrics().misses);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(pages[i], false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// batches of random page ids, FetchPages against one FetchPage per page
+// Timing only, run it with --gtest_also_run_disabled_tests
+TEST(BufferPoolManagerTest, DISABLED_FetchPagesBenchmark) {
+  const int num_pages = 4096;
+  const int pool_size = 256;
+  const int batch_size = 64;
+  const int num_batches = 2000;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  {
+    BufferPoolManagerInstance bpm(pool_size, disk_manager);
+    for (int i = 0; i < num_pages; ++i) {
+      Page *page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    }
+    for (int i = num_pages - pool_size; i < num_pages; ++i)
+      bpm.FlushPage(i);
+  }
+
+  std::vector<page_id_t> page_ids(batch_size * num_batches);
+  std::srand(0);
+  for (auto &page_id : page_ids)
+    page_id = std::rand() % num_pages;
+
+  double single_seconds, batch_seconds;
+  {
+    BufferPoolManagerInstance bpm(pool_size, disk_manager);
+    auto start = std::chrono::steady_clock::now();
+    for (int b = 0; b < num_batches; ++b) {
+      Page *pages[batch_size];
+      for (int i = 0; i < batch_size; ++i)
+        pages[i] = bpm.FetchPage(page_ids[b * batch_size + i]);
+      for (int i = 0; i < batch_size; ++i) {
+        ASSERT_NE(nullptr, pages[i]);
+        EXPECT_EQ(page_ids[b * batch_size + i],
+                  *reinterpret_cast<page_id_t *>(pages[i]->GetData()));
+        bpm.UnpinPage(pages[i], false);
+      }
+    }
+    single_seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  }
+  {
+    BufferPoolManagerInstance bpm(pool_size, disk_manager);
+    auto start = std::chrono::steady_clock::now();
+    for (int b = 0; b < num_batches; ++b) {
+      Page *pages[batch_size];
+      ASSERT_EQ(static_cast<size_t>(batch_size),
+                bpm.FetchPages(&page_ids[b * batch_size], batch_size, pages));
+      for (int i = 0; i < batch_size; ++i) {
+        EXPECT_EQ(page_ids[b * batch_size + i],
+                  *reinterpret_cast<page_id_t *>(pages[i]->GetData()));
+        bpm.UnpinPage(pages[i], false);
+      }
+    }
+    batch_seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  }
+  std::cout << num_batches << " batches of " << batch_size
+            << " random pages: FetchPage " << single_seconds
+            << "s, FetchPages " << batch_seconds << "s" << std::endl;
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  page_id_t temp_page_id;
+  remove("test.warm");
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  // no file of a previous run
+  bpm->EnableWarmUp("test.warm");
+  for (int i = 0; i < 20; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+    EXPECT_EQ(true, bpm->FlushPage(temp_page_id));
+  }
+  // 10 - 19 are resident, 12 is the most recently used, 15 is pinned
+  ASSERT_NE(nullptr, bpm->FetchPage(15));
+  ASSERT_NE(nullptr, bpm->FetchPage(12));
+  EXPECT_EQ(true, bpm->UnpinPage(12, false));
+  EXPECT_EQ(true, bpm->DumpResidentPages());
+  {
+    std::ifstream input("test.warm");
+    std::vector<page_id_t> page_ids;
+    while (input >> temp_page_id)
+      page_ids.push_back(temp_page_id);
+    ASSERT_EQ(10u, page_ids.size());
+    EXPECT_EQ(15, page_ids[0]);
+    EXPECT_EQ(12, page_ids[1]);
+    EXPECT_EQ(10, page_ids[9]);
+  }
+  EXPECT_EQ(true, bpm->UnpinPage(15, false));
+  delete bpm;
+  delete disk_manager;
+
+  // restart: the ten pages are read back before anyone asks for them
+  disk_manager = new DiskManager("test.db");
+  bpm = new BufferPoolManagerInstance(10, disk_manager);
+  bpm->EnableWarmUp("test.warm");
+  bpm->WaitForWarmUp();
+  EXPECT_EQ(10, disk_manager->GetNumReads());
+  for (int i = 10; i < 20; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(0u, bpm->GetMetrics().misses);
+  EXPECT_EQ(10, disk_manager->GetNumReads());
+  delete bpm;
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.warm");
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  for (ReplacerType replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK}) {
+    page_id_t temp_page_id;
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManagerInstance bpm(5, disk_manager, nullptr, replacer_type);
+
+    for (int i = 0; i < 5; ++i) {
+      Page *page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+    }
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+    // grow: three more free frames
+    EXPECT_EQ(8u, bpm.Resize(8));
+    EXPECT_EQ(8u, bpm.GetPoolSize());
+    for (int i = 5; i < 8; ++i) {
+      Page *page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+    }
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+    // shrink: pinned frames stay
+    EXPECT_EQ(8u, bpm.Resize(2));
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    }
+    // evicted pages are written back on the way out
+    EXPECT_EQ(2u, bpm.Resize(2));
+    EXPECT_EQ(2u, bpm.GetPoolSize());
+    for (int i = 0; i < 8; ++i) {
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+
+    // fetches keep going while the pool changes size under them
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < 4; ++tid) {
+      threads.push_back(std::thread([&bpm, &done, tid]() {
+        for (int n = 0; !done; ++n) {
+          page_id_t page_id = (tid + n) % 8;
+          Page *page = bpm.FetchPage(page_id);
+          if (page == nullptr)
+            continue;
+          EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+          EXPECT_EQ(true, bpm.UnpinPage(page, false));
+        }
+      }));
+    }
+    for (int round = 0; round < 200; ++round)
+      bpm.Resize(round % 2 == 0 ? 16 : 4);
+    done = true;
+    for (auto &thread : threads)
+      thread.join();
+    EXPECT_EQ(4u, bpm.Resize(4));
+
+    // a shrink gives the memory of the frames back
+    EXPECT_EQ(256u, bpm.Resize(256));
+    size_t grown = bpm.GetFrameMemory();
+    EXPECT_LE(static_cast<size_t>(256 * PAGE_SIZE), grown);
+    EXPECT_EQ(4u, bpm.Resize(4));
+    EXPECT_GT(grown / 4, bpm.GetFrameMemory());
+    EXPECT_EQ(64u, bpm.Resize(64));
+
+    delete disk_manager;
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, PageClassTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  // pages 0 and 1 play index pages, the others heap pages
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  }
+  Page *page = bpm.FetchPage(0, nullptr, PageClass::HEADER);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  page = bpm.FetchPage(1, nullptr, PageClass::INDEX_INTERNAL);
+  ASSERT_NE(nullptr, page);
+  // fetches without a hint keep the class
+  EXPECT_EQ(page, bpm.FetchPage(1));
+  EXPECT_EQ(PageClass::INDEX_INTERNAL, page->GetPageClass());
+  EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  EXPECT_EQ(true, bpm.UnpinPage(page, false));
+
+  // a burst of heap fetches cycles through the two remaining frames
+  for (int round = 0; round < 3; ++round)
+    for (int i = 2; i < 10; ++i) {
+      page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(true, bpm.UnpinPage(page, false));
+    }
+  size_t misses = bpm.GetMetrics().misses;
+  for (int i = 0; i < 2; ++i) {
+    page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  }
+  EXPECT_EQ(misses, bpm.GetMetrics().misses);
+
+  BufferPoolMetricsSnapshot metrics = bpm.GetMetrics();
+  EXPECT_EQ(2u, metrics.resident_pages[static_cast<int>(PageClass::DATA)]);
+  EXPECT_EQ(0u,
+            metrics.resident_pages[static_cast<int>(PageClass::INDEX_LEAF)]);
+  EXPECT_EQ(1u, metrics.resident_pages[static_cast<int>(
+                    PageClass::INDEX_INTERNAL)]);
+  EXPECT_EQ(1u, metrics.resident_pages[static_cast<int>(PageClass::HEADER)]);
+
+  // once no heap page is left to evict, index pages go too, lowest first
+  Page *pinned[3];
+  for (int i = 0; i < 2; ++i) {
+    pinned[i] = bpm.FetchPage(2 + i);
+    ASSERT_NE(nullptr, pinned[i]);
+  }
+  pinned[2] = bpm.FetchPage(4);
+  ASSERT_NE(nullptr, pinned[2]);
+  metrics = bpm.GetMetrics();
+  EXPECT_EQ(0u, metrics.resident_pages[static_cast<int>(
+                    PageClass::INDEX_INTERNAL)]);
+  EXPECT_EQ(1u, metrics.resident_pages[static_cast<int>(PageClass::HEADER)]);
+  for (auto p : pinned)
+    EXPECT_EQ(true, bpm.UnpinPage(p, false));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db", true);
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0u,
+              reinterpret_cast<uintptr_t>(page->GetData()) % DIRECT_IO_ALIGNMENT);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  }
+  // frames added by a resize are aligned too
+  EXPECT_EQ(6u, bpm.Resize(6));
+  for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+    Page *page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0u,
+              reinterpret_cast<uintptr_t>(page->GetData()) % DIRECT_IO_ALIGNMENT);
+    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(8, disk_manager);
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  }
+  // a pinned page is flushed too
+  Page *pinned = bpm.FetchPage(3);
+  ASSERT_NE(nullptr, pinned);
+  EXPECT_EQ(0u, bpm.FlushPages(8, 100));
+  EXPECT_EQ(3u, bpm.FlushPages(2, 4));
+  EXPECT_EQ(5u, bpm.FlushAllPages());
+  // everything is clean now
+  EXPECT_EQ(0u, bpm.FlushAllPages());
+  char data[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+    disk_manager->ReadPage(page_id, data);
+    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(data));
+  }
+  // a page dirtied while it is pinned is written again
+  EXPECT_EQ(true, bpm.UnpinPage(pinned, true));
+  EXPECT_EQ(1u, bpm.FlushAllPages());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// Timing only, run it with --gtest_also_run_disabled_tests
+TEST(BufferPoolManagerTest, DISABLED_FlushAllPagesBenchmark) {
+  const int num_pages = 4096;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(num_pages, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+    page_ids.push_back(temp_page_id);
+  }
+  // the dirty pages in no particular order, as frames are walked
+  std::srand(0);
+  for (int i = num_pages - 1; i > 0; --i)
+    std::swap(page_ids[i], page_ids[std::rand() % (i + 1)]);
+
+  // FlushPage leaves the pages dirty, FlushAllPages writes them all again
+  auto start = std::chrono::steady_clock::now();
+  for (page_id_t page_id : page_ids)
+    EXPECT_EQ(true, bpm.FlushPage(page_id));
+  double single_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  start = std::chrono::steady_clock::now();
+  EXPECT_EQ(static_cast<size_t>(num_pages), bpm.FlushAllPages());
+  double all_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  std::cout << num_pages << " dirty pages: FlushPage "
+            << num_pages / single_seconds << " pages/s, FlushAllPages "
+            << num_pages / all_seconds << " pages/s (x"
+            << single_seconds / all_seconds << ")" << std::endl;
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, SwizzleTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  // page 0 plays the parent, pages 1 to 5 its children
+  for (int i = 0; i < 6; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  }
+  Page *parent = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, parent);
+
+  // first fetch goes through the page table, the second through the swip
+  Page *child = bpm.FetchChild(parent, 1);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(true, bpm.UnpinPage(child, false));
+  size_t hits = bpm.GetMetrics().hits;
+  EXPECT_EQ(child, bpm.FetchChild(parent, 1));
+  EXPECT_EQ(hits + 1, bpm.GetMetrics().hits);
+  EXPECT_EQ(true, bpm.UnpinPage(child, false));
+
+  // evicting the child unswizzles it, the frame now holds another page
+  for (int i = 2; i < 6; ++i) {
+    Page *page = bpm.FetchChild(parent, i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  }
+  child = bpm.FetchChild(parent, 1);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(1, *reinterpret_cast<page_id_t *>(child->GetData()));
+  EXPECT_EQ(true, bpm.UnpinPage(child, false));
+
+  // deleting the child and evicting the parent leave no dangling swip
+  EXPECT_EQ(true, bpm.DeletePage(1));
+  EXPECT_EQ(true, bpm.UnpinPage(parent, false));
+  for (int i = 2; i < 6; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  }
+  parent = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, parent);
+  child = bpm.FetchChild(parent, 5);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(5, *reinterpret_cast<page_id_t *>(child->GetData()));
+  EXPECT_EQ(true, bpm.UnpinPage(child, false));
+  EXPECT_EQ(true, bpm.UnpinPage(parent, false));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// a swizzled hit takes the frame out of the replacer, the pinned child is not
+// listed a second time among the evictable pages
+TEST(BufferPoolManagerTest, SwizzleReplacerTest) {
+  page_id_t temp_page_id;
+  remove("test.warm");
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(4, disk_manager);
+  bpm->EnableWarmUp("test.warm");
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+  }
+  Page *parent = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, parent);
+  Page *child = bpm->FetchChild(parent, 1);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(true, bpm->UnpinPage(child, false));
+  EXPECT_EQ(child, bpm->FetchChild(parent, 1));
+  EXPECT_EQ(true, bpm->DumpResidentPages());
+  {
+    std::ifstream input("test.warm");
+    std::vector<page_id_t> page_ids;
+    while (input >> temp_page_id)
+      page_ids.push_back(temp_page_id);
+    EXPECT_EQ(3u, page_ids.size());
+    EXPECT_EQ(1, std::count(page_ids.begin(), page_ids.end(), 1));
+  }
+  EXPECT_EQ(true, bpm->UnpinPage(child, false));
+  EXPECT_EQ(true, bpm->UnpinPage(parent, false));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.warm");
+}
+
+// swizzled hits pin frames without the latch while other threads evict and
+// reuse them
+TEST(BufferPoolManagerTest, SwizzleConcurrentTest) {
+  const int num_children = 24;
+  const int num_threads = 4;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(8, disk_manager);
+  for (int i = 0; i <= num_children; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = temp_page_id;
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  }
+  Page *parent = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, parent);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.push_back(std::thread([&bpm, parent, t]() {
+      std::srand(t);
+      for (int i = 0; i < 5000; ++i) {
+        // a few hot children stay swizzled, the others keep evicting them
+        page_id_t child_id = 1 + (i % 2 == 0 ? std::rand() % 3
+                                             : std::rand() % num_children);
+        Page *child = bpm.FetchChild(parent, child_id);
+        if (child == nullptr)
+          continue;
+        if (child_id != child->GetPageId() ||
+            child_id != *reinterpret_cast<page_id_t *>(child->GetData())) {
+          ADD_FAILURE() << "child " << child_id << " in a frame of page "
+                        << child->GetPageId();
+        }
+        bpm.UnpinPage(child, false);
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+  // every pin was dropped: all frames but the parent's can be reused
+  for (int i = 1; i <= 7; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// Timing only, run it with --gtest_also_run_disabled_tests
+TEST(BufferPoolManagerTest, DISABLED_SwizzleBenchmark) {
+  // descent steps of lookups in a two level tree that fits in the pool
+  const int fanout = 32;
+  const int num_lookups = 200000;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(fanout + 1, disk_manager);
+  for (int i = 0; i <= fanout; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  }
+  std::vector<page_id_t> page_ids(num_lookups);
+  std::srand(0);
+  for (auto &page_id : page_ids)
+    page_id = 1 + std::rand() % fanout;
+
+  double seconds[2];
+  for (int swizzled = 0; swizzled < 2; ++swizzled) {
+    auto start = std::chrono::steady_clock::now();
+    for (page_id_t page_id : page_ids) {
+      Page *root = bpm.FetchPage(0);
+      Page *leaf = swizzled ? bpm.FetchChild(root, page_id)
+                            : bpm.FetchPage(page_id);
+      bpm.UnpinPage(leaf, false);
+      bpm.UnpinPage(root, false);
+    }
+    seconds[swizzled] = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  }
+  EXPECT_EQ(0u, bpm.GetMetrics().misses);
+  std::cout << num_lookups << " lookups: page table "
+            << num_lookups / seconds[0] << "/s, swizzled "
+            << num_lookups / seconds[1] << "/s (x" << seconds[0] / seconds[1]
+            << ")" << std::endl;
+
+  delete disk_manager;
+  remove("test.db");
+}
+
 } // namespace cmudb
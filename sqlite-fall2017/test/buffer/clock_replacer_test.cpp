@@ -0,0 +1,91 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer<int> clock_replacer({1, 2, 3, 4, 5, 6, 7});
+
+  // push element into replacer
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  clock_replacer.Insert(4);
+  clock_replacer.Insert(5);
+  clock_replacer.Insert(6);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // the first sweep clears every reference bit, the second one evicts in
+  // clock order
+  int value;
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+
+  // 3 gets referenced again, so it survives one more round
+  clock_replacer.Insert(3);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, clock_replacer.Erase(4));
+  EXPECT_EQ(false, clock_replacer.Erase(7));
+  EXPECT_EQ(true, clock_replacer.Erase(6));
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // pop element from replacer after removal
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, ConcurrentPinUnpinTest) {
+  const int num_frames = 64;
+  const int num_threads = 4;
+  std::vector<int> frames;
+  for (int i = 0; i < num_frames; i++)
+    frames.push_back(i);
+  ClockReplacer<int> clock_replacer(frames);
+
+  // every thread owns a disjoint set of frames and pins/unpins them
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &clock_replacer]() {
+      for (int round = 0; round < 1000; round++) {
+        for (int i = tid; i < num_frames; i += num_threads) {
+          clock_replacer.Insert(i);
+          clock_replacer.Erase(i);
+          clock_replacer.Insert(i);
+        }
+      }
+    }));
+  }
+  for (auto &t : threads)
+    t.join();
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+
+  // every frame is evicted exactly once
+  std::vector<bool> seen(num_frames, false);
+  int value;
+  for (int i = 0; i < num_frames; i++) {
+    EXPECT_EQ(true, clock_replacer.Victim(value));
+    EXPECT_EQ(false, seen[value]);
+    seen[value] = true;
+  }
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+}
+
+} // namespace cmudb
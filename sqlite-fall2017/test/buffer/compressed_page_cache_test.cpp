@@ -0,0 +1,148 @@
+/**
+ * compressed_page_cache_test.cpp
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/compressed_page_cache.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(CompressedPageCacheTest, CodecTest) {
+  char page[PAGE_SIZE], result[PAGE_SIZE];
+  std::string compressed;
+
+  // zeroed page, a run
+  memset(page, 0, PAGE_SIZE);
+  EXPECT_EQ(true, CompressedPageCache::Compress(page, PAGE_SIZE, compressed));
+  EXPECT_LT(compressed.size(), static_cast<size_t>(PAGE_SIZE / 10));
+  CompressedPageCache::Decompress(compressed, result, PAGE_SIZE);
+  EXPECT_EQ(0, memcmp(page, result, PAGE_SIZE));
+
+  // tuple-like records sharing most of their bytes, with free space
+  for (int i = 0; i < PAGE_SIZE / 2; i += 16)
+    snprintf(page + i, 16, "tuple-%07d", i);
+  EXPECT_EQ(true, CompressedPageCache::Compress(page, PAGE_SIZE, compressed));
+  EXPECT_LT(compressed.size(), static_cast<size_t>(PAGE_SIZE / 2));
+  CompressedPageCache::Decompress(compressed, result, PAGE_SIZE);
+  EXPECT_EQ(0, memcmp(page, result, PAGE_SIZE));
+
+  // random bytes do not compress
+  std::srand(0);
+  for (int i = 0; i < PAGE_SIZE; ++i)
+    page[i] = static_cast<char>(std::rand());
+  EXPECT_EQ(false, CompressedPageCache::Compress(page, PAGE_SIZE, compressed));
+}
+
+TEST(CompressedPageCacheTest, BudgetTest) {
+  char page[PAGE_SIZE], result[PAGE_SIZE];
+  std::srand(0);
+  for (int i = 0; i < PAGE_SIZE; ++i)
+    page[i] = static_cast<char>(std::rand());
+
+  // incompressible pages are kept raw, so three of them fit
+  CompressedPageCache cache(3 * PAGE_SIZE);
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    page[0] = static_cast<char>(page_id);
+    cache.Insert(page_id, page);
+  }
+  EXPECT_EQ(3u, cache.GetNumPages());
+  EXPECT_EQ(static_cast<size_t>(3 * PAGE_SIZE), cache.GetSize());
+
+  // the first stored pages were dropped
+  EXPECT_EQ(false, cache.Lookup(0, result));
+  EXPECT_EQ(false, cache.Lookup(1, result));
+  EXPECT_EQ(true, cache.Lookup(2, result));
+  EXPECT_EQ(2, result[0]);
+  // handed out pages leave the cache
+  EXPECT_EQ(false, cache.Lookup(2, result));
+  cache.Erase(3);
+  EXPECT_EQ(false, cache.Lookup(3, result));
+  EXPECT_EQ(1u, cache.GetNumPages());
+  EXPECT_EQ(1u, cache.GetHits());
+  EXPECT_EQ(4u, cache.GetMisses());
+}
+
+TEST(CompressedPageCacheTest, StageTest) {
+  char page[PAGE_SIZE], result[PAGE_SIZE];
+  memset(page, 0, PAGE_SIZE);
+
+  // staged pages are served raw until the compress thread gets to them
+  CompressedPageCache cache(10 * PAGE_SIZE);
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    snprintf(page, PAGE_SIZE, "page %d", page_id);
+    cache.Stage(page_id, page);
+  }
+  EXPECT_EQ(true, cache.Lookup(0, result));
+  EXPECT_EQ("page 0", std::string(result));
+  cache.WaitForCompression();
+  EXPECT_EQ(4u, cache.GetNumPages());
+  EXPECT_LT(cache.GetSize(), static_cast<size_t>(PAGE_SIZE));
+  for (page_id_t page_id = 1; page_id < 5; ++page_id) {
+    EXPECT_EQ(true, cache.Lookup(page_id, result));
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(result));
+  }
+
+  // a page staged again before it was compressed keeps its last copy
+  snprintf(page, PAGE_SIZE, "old");
+  cache.Stage(7, page);
+  snprintf(page, PAGE_SIZE, "new");
+  cache.Stage(7, page);
+  cache.WaitForCompression();
+  EXPECT_EQ(true, cache.Lookup(7, result));
+  EXPECT_EQ("new", std::string(result));
+}
+
+TEST(CompressedPageCacheTest, BufferPoolTest) {
+  const int num_pages = 20;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  bpm.EnableCompressedCache(num_pages * PAGE_SIZE);
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  }
+
+  // evicted pages come back from the compressed cache, not from disk
+  int reads = disk_manager->GetNumReads();
+  for (int i = 0; i < num_pages - 4; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  }
+  EXPECT_EQ(reads, disk_manager->GetNumReads());
+  EXPECT_EQ(static_cast<size_t>(num_pages - 4),
+            bpm.GetCompressedCache()->GetHits());
+
+  // a deleted page is dropped from the cache as well, even when it is not
+  // in the pool (DeletePage then reports false)
+  size_t cached = bpm.GetCompressedCache()->GetNumPages();
+  EXPECT_EQ(false, bpm.DeletePage(num_pages - 1));
+  EXPECT_EQ(cached - 1, bpm.GetCompressedCache()->GetNumPages());
+
+  // batch fetches take the cache too
+  page_id_t page_ids[] = {num_pages - 4, num_pages - 3, num_pages - 2};
+  Page *pages[3];
+  EXPECT_EQ(3u, bpm.FetchPages(page_ids, 3, pages));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ("page " + std::to_string(page_ids[i]),
+              std::string(pages[i]->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(pages[i], false));
+  }
+  EXPECT_EQ(reads, disk_manager->GetNumReads());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,134 @@
+/**
+ * flash_cache_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/flash_cache.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(FlashCacheTest, SlotRingTest) {
+  char page[PAGE_SIZE], result[PAGE_SIZE];
+  memset(page, 0, PAGE_SIZE);
+
+  FlashCache cache("test.cache", 3);
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    snprintf(page, PAGE_SIZE, "page %d", page_id);
+    cache.Insert(page_id, page);
+  }
+  // page 3 took the slot of page 0
+  EXPECT_EQ(3u, cache.GetNumPages());
+  EXPECT_EQ(false, cache.Lookup(0, result));
+  for (page_id_t page_id = 1; page_id < 4; ++page_id) {
+    EXPECT_EQ(true, cache.Lookup(page_id, result));
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(result));
+  }
+  // copies stay after a lookup, a second insert writes nothing
+  cache.Insert(3, page);
+  EXPECT_EQ(4u, cache.GetWrites());
+  cache.Erase(2);
+  EXPECT_EQ(false, cache.Lookup(2, result));
+  EXPECT_EQ(3u, cache.GetHits());
+  EXPECT_EQ(2u, cache.GetMisses());
+
+  remove("test.cache");
+}
+
+TEST(FlashCacheTest, StageTest) {
+  char page[PAGE_SIZE], result[PAGE_SIZE];
+  memset(page, 0, PAGE_SIZE);
+
+  FlashCache cache("test.cache", 4);
+  for (page_id_t page_id = 0; page_id < 3; ++page_id) {
+    snprintf(page + 8, PAGE_SIZE - 8, "page %d", page_id);
+    cache.Stage(page_id, page);
+  }
+  // a page dropped before the writer gets to it is never written
+  cache.Erase(2);
+  cache.WaitForWrites();
+  EXPECT_EQ(2u, cache.GetNumPages());
+  EXPECT_GE(3u, cache.GetWrites());
+  for (page_id_t page_id = 0; page_id < 2; ++page_id) {
+    EXPECT_EQ(true, cache.Lookup(page_id, result));
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(result + 8));
+  }
+  EXPECT_EQ(false, cache.Lookup(2, result));
+
+  // the written LSN guards against a torn or overwritten slot. Page 0 went
+  // to the first slot
+  std::fstream file("test.cache",
+                    std::ios::binary | std::ios::in | std::ios::out);
+  lsn_t lsn = 42;
+  file.seekp(4);
+  file.write(reinterpret_cast<const char *>(&lsn), sizeof(lsn));
+  file.close();
+  EXPECT_EQ(false, cache.Lookup(0, result));
+  EXPECT_EQ(true, cache.Lookup(1, result));
+  EXPECT_EQ(1u, cache.GetNumPages());
+
+  remove("test.cache");
+}
+
+TEST(FlashCacheTest, BufferPoolTest) {
+  const int num_pages = 12;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  bpm.EnableFlashCache("test.cache", num_pages);
+  FlashCache *cache = bpm.GetFlashCache();
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData() + 8, PAGE_SIZE - 8, "page %d", temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  }
+
+  // evicted pages come back from the cache file, not from the database file
+  int reads = disk_manager->GetNumReads();
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData() + 8));
+    EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  }
+  EXPECT_EQ(reads, disk_manager->GetNumReads());
+  EXPECT_EQ(4u, cache->GetHits());
+
+  // page 0 is rewritten: the cached copy of its old version is dropped on
+  // write back, and eviction caches the new one
+  Page *page = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  page->SetLSN(10);
+  snprintf(page->GetData() + 8, PAGE_SIZE - 8, "page 0 version 2");
+  EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  EXPECT_EQ(true, bpm.FlushPage(0));
+  for (int i = 4; i < 8; ++i) {
+    page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  }
+  page = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(10, page->GetLSN());
+  EXPECT_EQ("page 0 version 2", std::string(page->GetData() + 8));
+  EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  EXPECT_EQ(reads, disk_manager->GetNumReads());
+
+  // a deleted page is dropped from the cache
+  size_t cached = cache->GetNumPages();
+  bpm.DeletePage(num_pages - 1);
+  EXPECT_EQ(cached - 1, cache->GetNumPages());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.cache");
+}
+
+} // namespace cmudb
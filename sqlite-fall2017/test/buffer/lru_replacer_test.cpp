@@ -2,7 +2,10 @@
  * lru_replacer_test.cpp
  */
 
+#include <chrono>
 #include <cstdio>
+#include <iostream>
+#include <random>
 
 #include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
@@ -43,4 +46,35 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(1, value);
 }
 
+// hit path of the buffer pool: Erase on fetch, Insert on unpin. The cost per
+// pair should not grow with the number of values held by the replacer.
+// Timing only, run it with --gtest_also_run_disabled_tests
+TEST(LRUReplacerTest, DISABLED_HitPathBenchmark) {
+  const int num_ops = 100000;
+  const std::vector<int> pool_sizes{1000, 10000, 100000};
+  std::mt19937 gen(15445);
+
+  for (int pool_size : pool_sizes) {
+    LRUReplacer<int> lru_replacer;
+    for (int i = 0; i < pool_size; i++)
+      lru_replacer.Insert(i);
+    std::uniform_int_distribution<int> dist(0, pool_size - 1);
+    std::vector<int> trace(num_ops);
+    for (auto &v : trace)
+      v = dist(gen);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int v : trace) {
+      lru_replacer.Erase(v);
+      lru_replacer.Insert(v);
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(static_cast<size_t>(pool_size), lru_replacer.Size());
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "pool size " << pool_size << ": " << ns / num_ops
+              << " ns per erase/insert" << std::endl;
+  }
+}
+
 } // namespace cmudb
@@ -0,0 +1,201 @@
+/**
+ * parallel_buffer_pool_manager_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // 5 instances of 2 frames each
+  ParallelBufferPoolManager bpm(5, 2, disk_manager);
+  EXPECT_EQ(10u, bpm.GetPoolSize());
+
+  auto page_zero = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, temp_page_id);
+  strcpy(page_zero->GetData(), "Hello");
+
+  // allocation goes round robin, every instance gets two pages
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(i, temp_page_id);
+  }
+  // all the pages are pinned, the buffer pool is full
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // unpin page zero, only its instance has a free frame now
+  EXPECT_EQ(true, bpm.UnpinPage(0, true));
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(0, temp_page_id % 5);
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // read page zero back from disk
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  page_zero = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  EXPECT_EQ(false, bpm.UnpinPage(0, false));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// page ids come from disk manager, a pool on the same file after a restart
+// allocates after the pages written before
+TEST(ParallelBufferPoolManagerTest, RestartTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new ParallelBufferPoolManager(3, 4, disk_manager);
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  bpm = new ParallelBufferPoolManager(3, 4, disk_manager);
+  Page *page = bpm->NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(8, temp_page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 8; ++i) {
+    page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+// an id NewPage could not place in its full instance is used by a later
+// NewPage, failed calls do not leave holes of unused ids in the file
+TEST(ParallelBufferPoolManagerTest, SpareIdTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager bpm(3, 1, disk_manager);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(i, temp_page_id);
+  }
+  for (int i = 0; i < 5; ++i)
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // only the instance of page 1 has a frame
+  EXPECT_EQ(true, bpm.UnpinPage(1, false));
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(4, temp_page_id);
+  EXPECT_EQ(true, bpm.UnpinPage(4, false));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  EXPECT_EQ(true, bpm.UnpinPage(2, false));
+
+  // the other ids taken by the failed calls come next, then new ones
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    page_ids.push_back(temp_page_id);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  EXPECT_EQ(std::vector<page_id_t>({3, 5, 6}), page_ids);
+
+  // frames that do not split evenly go to the first instances
+  EXPECT_EQ(10u, bpm.Resize(10));
+  EXPECT_EQ(10u, bpm.GetPoolSize());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// fetch and unpin random resident pages from num_threads threads
+// return fetch/unpin pairs per second
+template <typename BPM>
+double FetchUnpinThroughput(BPM &bpm, int num_pages, int num_threads,
+                            int ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; ++t) {
+    threads.push_back(std::thread([&bpm, num_pages, ops_per_thread, t]() {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<int> page(0, num_pages - 1);
+      for (int i = 0; i < ops_per_thread; ++i) {
+        page_id_t page_id = page(gen);
+        Page *p = bpm.FetchPage(page_id);
+        EXPECT_NE(nullptr, p);
+        if (p != nullptr)
+          bpm.UnpinPage(page_id, false);
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return num_threads * ops_per_thread / elapsed.count();
+}
+
+// one pool against 16 instances of the same total size, all pages resident
+// Timing only, run it with --gtest_also_run_disabled_tests
+TEST(ParallelBufferPoolManagerTest, DISABLED_ScalingBenchmark) {
+  const int num_instances = 16;
+  const int num_pages = 1024;
+  const int ops_per_thread = 20000;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManagerInstance single(num_pages, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, single.NewPage(temp_page_id));
+    EXPECT_EQ(true, single.UnpinPage(temp_page_id, false));
+  }
+  // page ids of a disk manager are unique, the pools need one each
+  DiskManager *parallel_disk_manager = new DiskManager("parallel.db");
+  ParallelBufferPoolManager parallel(num_instances, num_pages / num_instances,
+                                     parallel_disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, parallel.NewPage(temp_page_id));
+    EXPECT_EQ(true, parallel.UnpinPage(temp_page_id, false));
+  }
+
+  for (int num_threads = 1; num_threads <= 32; num_threads *= 2) {
+    double single_ops =
+        FetchUnpinThroughput(single, num_pages, num_threads, ops_per_thread);
+    double parallel_ops =
+        FetchUnpinThroughput(parallel, num_pages, num_threads, ops_per_thread);
+    std::cout << num_threads << " threads, fetch/unpin per second: 1 instance "
+              << static_cast<long>(single_ops) << ", " << num_instances
+              << " instances " << static_cast<long>(parallel_ops)
+              << std::endl;
+  }
+
+  delete disk_manager;
+  delete parallel_disk_manager;
+  remove("test.db");
+  remove("parallel.db");
+}
+
+} // namespace cmudb
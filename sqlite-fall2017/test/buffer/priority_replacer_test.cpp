@@ -0,0 +1,68 @@
+/**
+ * priority_replacer_test.cpp
+ */
+
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/priority_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// values below 10 are of class 0, the others of class 1
+static size_t ClassOf(const int &value) { return value < 10 ? 0 : 1; }
+
+TEST(PriorityReplacerTest, SampleTest) {
+  PriorityReplacer<int> replacer(
+      {new LRUReplacer<int>, new LRUReplacer<int>}, ClassOf);
+
+  replacer.Insert(11);
+  replacer.Insert(1);
+  replacer.Insert(12);
+  replacer.Insert(2);
+  replacer.Insert(3);
+  EXPECT_EQ(5u, replacer.Size());
+
+  std::vector<int> victims;
+  replacer.PeekVictims(4, victims);
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 11}), victims);
+
+  // class 1 is only touched once class 0 is exhausted
+  int value;
+  EXPECT_EQ(true, replacer.Erase(2));
+  EXPECT_EQ(false, replacer.Erase(2));
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(11, value);
+  replacer.Insert(4);
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(12, value);
+  EXPECT_EQ(false, replacer.Victim(value));
+  EXPECT_EQ(0u, replacer.Size());
+}
+
+TEST(PriorityReplacerTest, ClockTest) {
+  std::vector<int> frames = {1, 2, 11, 12};
+  PriorityReplacer<int> replacer(
+      {new ClockReplacer<int>(frames), new ClockReplacer<int>(frames)},
+      ClassOf);
+  for (int value : frames)
+    replacer.Insert(value);
+  int value;
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(true, value < 10);
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(true, value < 10);
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(true, value >= 10);
+  EXPECT_EQ(1u, replacer.Size());
+}
+
+} // namespace cmudb
@@ -2,10 +2,12 @@
  * rwmutex_test.cpp
  */
 
+#include <atomic>
 #include <thread>
 
 #include "common/rwmutex.h"
 #include "gtest/gtest.h"
+#include "page/page.h"
 
 namespace cmudb {
 
@@ -50,4 +52,59 @@ TEST(RWMutexTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+TEST(RWMutexTest, PageOptimisticReadTest) {
+  Page page;
+  uint64_t version = page.OptimisticRead();
+  EXPECT_TRUE(page.Validate(version));
+  // readers do not change the version
+  page.RLatch();
+  page.RUnlatch();
+  EXPECT_TRUE(page.Validate(version));
+
+  page.WLatch();
+  EXPECT_FALSE(page.Validate(version));
+  // a read during a write never validates
+  EXPECT_FALSE(page.Validate(page.OptimisticRead()));
+  page.WUnlatch();
+  EXPECT_FALSE(page.Validate(version));
+  EXPECT_TRUE(page.Validate(page.OptimisticRead()));
+}
+
+// a writer keeps both halves of the page equal, an optimistic reader that
+// validates must never see them differ
+TEST(RWMutexTest, PageOptimisticReadConcurrentTest) {
+  Page page;
+  std::atomic<bool> done(false);
+  std::thread writer([&page, &done]() {
+    int *data = reinterpret_cast<int *>(page.GetData());
+    for (int i = 1; i <= 100000; i++) {
+      page.WLatch();
+      data[0] = i;
+      data[PAGE_SIZE / sizeof(int) - 1] = i;
+      page.WUnlatch();
+    }
+    done = true;
+  });
+  std::vector<std::thread> readers;
+  std::atomic<int> validated(0);
+  for (int tid = 0; tid < 4; tid++) {
+    readers.push_back(std::thread([&page, &done, &validated]() {
+      volatile int *data = reinterpret_cast<int *>(page.GetData());
+      while (!done) {
+        uint64_t version = page.OptimisticRead();
+        int first = data[0];
+        int last = data[PAGE_SIZE / sizeof(int) - 1];
+        if (page.Validate(version)) {
+          EXPECT_EQ(first, last);
+          validated++;
+        }
+      }
+    }));
+  }
+  writer.join();
+  for (auto &reader : readers)
+    reader.join();
+  EXPECT_TRUE(page.Validate(page.OptimisticRead()));
+}
 }
@@ -40,4 +40,52 @@ TEST(LockManagerTest, BasicTest) {
   t0.join();
   t1.join();
 }
+
+TEST(LockManagerTest, LinearLockTableTest) {
+  LockManager lock_mgr{false, HashTableType::LINEAR};
+  TransactionManager txn_mgr{&lock_mgr};
+
+  Transaction txn0(0);
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(lock_mgr.LockShared(&txn0, RID{i, 0}));
+  }
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(lock_mgr.LockUpgrade(&txn0, RID{i, 0}));
+  }
+  // a younger transaction dies
+  Transaction txn1(1);
+  EXPECT_FALSE(lock_mgr.LockShared(&txn1, RID{500, 0}));
+  EXPECT_EQ(TransactionState::ABORTED, txn1.GetState());
+  txn_mgr.Commit(&txn0);
+  EXPECT_EQ(TransactionState::COMMITTED, txn0.GetState());
+}
+
+// the entry of a rid goes with its last lock, so the directory of the lock
+// table shrinks back after a spike of locked tuples
+TEST(LockManagerTest, ShrinkLockTableTest) {
+  LockManager lock_mgr{false};
+  TransactionManager txn_mgr{&lock_mgr};
+  auto lock_table = dynamic_cast<ExtendibleHash<RID, LockManager::TxnList *> *>(
+      lock_mgr.GetLockTable());
+  ASSERT_NE(nullptr, lock_table);
+  int initial_depth = lock_table->GetGlobalDepth();
+
+  Transaction txn0(0);
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(lock_mgr.LockShared(&txn0, RID{i, 0}));
+  }
+  int spike_depth = lock_table->GetGlobalDepth();
+  EXPECT_GT(spike_depth, initial_depth);
+  txn_mgr.Commit(&txn0);
+  EXPECT_LT(lock_table->GetGlobalDepth(), spike_depth);
+
+  // an aborted request leaves no entry either
+  Transaction txn1(1);
+  Transaction txn2(2);
+  EXPECT_TRUE(lock_mgr.LockExclusive(&txn1, RID{0, 0}));
+  EXPECT_FALSE(lock_mgr.LockShared(&txn2, RID{0, 0}));
+  txn_mgr.Commit(&txn1);
+  LockManager::TxnList *txn_list;
+  EXPECT_FALSE(lock_table->Find(RID{0, 0}, txn_list));
+}
 } // namespace cmudb
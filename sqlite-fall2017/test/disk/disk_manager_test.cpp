@@ -0,0 +1,81 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(DiskManagerTest, DirectIOTest) {
+  // works the same whether the file system takes O_DIRECT or not
+  char *aligned = nullptr;
+  ASSERT_EQ(0, posix_memalign(reinterpret_cast<void **>(&aligned),
+                              DIRECT_IO_ALIGNMENT, 2 * PAGE_SIZE));
+  char unaligned_storage[PAGE_SIZE + 1];
+  char *unaligned = unaligned_storage + 1;
+  char result[PAGE_SIZE];
+
+  {
+    DiskManager disk_manager("test.db", true);
+    memset(aligned, 'a', PAGE_SIZE);
+    memset(unaligned, 'u', PAGE_SIZE);
+    disk_manager.WritePage(0, aligned);
+    disk_manager.WritePage(1, unaligned);
+
+    disk_manager.ReadPage(1, aligned + PAGE_SIZE);
+    EXPECT_EQ(0, memcmp(aligned + PAGE_SIZE, unaligned, PAGE_SIZE));
+    disk_manager.ReadPage(0, result);
+    EXPECT_EQ(0, memcmp(result, aligned, PAGE_SIZE));
+    // a page past the end of the file reads as zeros
+    disk_manager.ReadPage(2, result);
+    EXPECT_EQ(0, result[0]);
+
+    page_id_t page_ids[] = {0, 1};
+    char *page_data[] = {unaligned, aligned};
+    disk_manager.ReadPages(page_ids, page_data, 2);
+    EXPECT_EQ('a', unaligned[PAGE_SIZE - 1]);
+    EXPECT_EQ('u', aligned[0]);
+  }
+  // and a buffered disk manager sees what was written directly
+  DiskManager disk_manager("test.db");
+  disk_manager.ReadPage(1, result);
+  EXPECT_EQ('u', result[PAGE_SIZE - 1]);
+  EXPECT_EQ(false, disk_manager.IsDirectIO());
+
+  free(aligned);
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, WritePagesTest) {
+  for (int direct_io = 0; direct_io < 2; ++direct_io) {
+    DiskManager disk_manager("test.db", direct_io);
+    char *buffer = nullptr;
+    ASSERT_EQ(0, posix_memalign(reinterpret_cast<void **>(&buffer),
+                                DIRECT_IO_ALIGNMENT, 6 * PAGE_SIZE));
+    page_id_t page_ids[] = {1, 2, 3, 5, 6, 9};
+    const char *page_data[6];
+    for (int i = 0; i < 6; ++i) {
+      memset(buffer + i * PAGE_SIZE, 'a' + i + direct_io, PAGE_SIZE);
+      page_data[i] = buffer + i * PAGE_SIZE;
+    }
+    // runs 1-3, 5-6 and 9
+    EXPECT_EQ(3, disk_manager.WritePages(page_ids, page_data, 6));
+
+    char result[PAGE_SIZE];
+    for (int i = 0; i < 6; ++i) {
+      disk_manager.ReadPage(page_ids[i], result);
+      EXPECT_EQ(0, memcmp(result, page_data[i], PAGE_SIZE));
+    }
+    free(buffer);
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
@@ -2,7 +2,11 @@
  * extendible_hash_test.cpp
  */
 
+#include <atomic>
+#include <chrono>
+#include <iostream>
 #include <thread>
+#include <vector>
 
 #include "hash/extendible_hash.h"
 #include "gtest/gtest.h"
@@ -47,6 +51,204 @@ TEST(ExtendibleHashTest, SampleTest) {
   delete test;
 }
 
+TEST(ExtendibleHashTest, FingerprintTest) {
+  // buckets of several fingerprint groups, and a last group not full
+  ExtendibleHash<int, int> test(FINGERPRINT_GROUP * 2 + 3);
+  for (int i = 0; i < 1000; i++)
+    test.Insert(i, i);
+  for (int i = 0; i < 1000; i += 2)
+    EXPECT_EQ(1, test.Remove(i));
+  int value;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(i % 2, test.Find(i, value));
+    if (i % 2 == 1) {
+      EXPECT_EQ(i, value);
+    }
+  }
+  // the emptied slots are taken again, an update keeps the one slot
+  for (int i = 0; i < 1000; i += 2)
+    test.Insert(i, -i);
+  test.Insert(1, 100);
+  EXPECT_EQ(1, test.Remove(1));
+  EXPECT_EQ(0, test.Find(1, value));
+  EXPECT_EQ(1, test.Find(998, value));
+  EXPECT_EQ(-998, value);
+}
+
+TEST(ExtendibleHashTest, OptimisticReadTest) {
+  // readers see every key that was there all along, and keys being inserted
+  // either not at all or with their value, while the table keeps splitting
+  ExtendibleHash<int, int> test(4);
+  const int num_old = 1000;
+  for (int i = 0; i < num_old; i++)
+    test.Insert(i, i);
+  std::atomic<bool> done(false);
+  std::atomic<int> errors(0);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; tid++) {
+    threads.push_back(std::thread([&test, &done, &errors, tid]() {
+      int value;
+      for (int i = tid; !done; i = (i + 7) % (num_old * 20)) {
+        bool found = test.Find(i, value);
+        if ((i < num_old && !found) || (found && value != i))
+          errors++;
+      }
+    }));
+  }
+  std::vector<std::thread> writers;
+  for (int tid = 0; tid < 4; tid++) {
+    writers.push_back(std::thread([&test, tid]() {
+      for (int i = num_old + tid; i < num_old * 20; i += 4)
+        test.Insert(i, i);
+    }));
+  }
+  for (auto &writer : writers)
+    writer.join();
+  done = true;
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(0, errors);
+  int value;
+  for (int i = 0; i < num_old * 20; i++) {
+    EXPECT_TRUE(test.Find(i, value));
+    EXPECT_EQ(i, value);
+  }
+}
+
+TEST(ExtendibleHashTest, ReclaimTest) {
+  // two shards take turns holding a reader, so some shard is always busy:
+  // what splits retire is still freed once each shard was seen empty
+  ExtendibleHash<int, int> test(4);
+  int key = 0;
+  for (int round = 0; round < 100; round++) {
+    unsigned shard = round % 2;
+    test.EnterReaderShard(shard);
+    if (round > 0)
+      test.LeaveReaderShard(1 - shard);
+    for (int i = 0; i < 20; i++, key++)
+      test.Insert(key, key);
+  }
+  test.LeaveReaderShard(1);
+  EXPECT_GT(200u, test.GetRetiredCount());
+  // the next split frees the rest
+  for (int i = 0; i < 100; i++, key++)
+    test.Insert(key, key);
+  EXPECT_EQ(0u, test.GetRetiredCount());
+  int value;
+  for (int i = 0; i < key; i++) {
+    EXPECT_TRUE(test.Find(i, value));
+    EXPECT_EQ(i, value);
+  }
+}
+
+TEST(ExtendibleHashTest, MergeTest) {
+  ExtendibleHash<int, int> test(8, 0.25);
+  int steady_depth = test.GetGlobalDepth();
+  int steady_buckets = test.GetNumBuckets();
+  // a spike: the directory grows well past the steady state
+  for (int i = 0; i < 10000; i++)
+    test.Insert(i, i);
+  EXPECT_GT(test.GetGlobalDepth(), 10);
+  EXPECT_GT(test.GetNumBuckets(), 1250);
+  // drained back to a few keys, buckets merge and the directory shrinks
+  for (int i = 4; i < 10000; i++) {
+    EXPECT_TRUE(test.Remove(i));
+  }
+  EXPECT_EQ(steady_depth, test.GetGlobalDepth());
+  EXPECT_EQ(steady_buckets, test.GetNumBuckets());
+  int value;
+  for (int i = 0; i < 10000; i++) {
+    if (i < 4) {
+      EXPECT_TRUE(test.Find(i, value));
+      EXPECT_EQ(i, value);
+    } else {
+      EXPECT_FALSE(test.Find(i, value));
+    }
+  }
+  // and grows again
+  for (int i = 0; i < 10000; i++)
+    test.Insert(i, -i);
+  for (int i = 0; i < 10000; i++) {
+    EXPECT_TRUE(test.Find(i, value));
+    EXPECT_EQ(-i, value);
+  }
+
+  // without a merge fill the buckets are kept
+  ExtendibleHash<int, int> kept(8);
+  for (int i = 0; i < 10000; i++)
+    kept.Insert(i, i);
+  int depth = kept.GetGlobalDepth();
+  for (int i = 0; i < 10000; i++)
+    kept.Remove(i);
+  EXPECT_EQ(depth, kept.GetGlobalDepth());
+}
+
+TEST(ExtendibleHashTest, ConcurrentMergeTest) {
+  // readers look up stable keys while a writer spikes and drains the table
+  ExtendibleHash<int, int> test(8, 0.25);
+  const int stable = 100;
+  for (int i = 0; i < stable; i++)
+    test.Insert(i, i);
+  std::atomic<bool> done(false);
+  std::atomic<int> misses(0);
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.emplace_back([&test, &done, &misses, tid]() {
+      int value;
+      for (int i = tid; !done; i = (i + 1) % stable)
+        if (!test.Find(i, value) || value != i)
+          misses++;
+    });
+  }
+  for (int round = 0; round < 5; round++) {
+    for (int i = stable; i < 20000; i++)
+      test.Insert(i, i);
+    for (int i = stable; i < 20000; i++)
+      test.Remove(i);
+  }
+  done = true;
+  for (auto &reader : readers)
+    reader.join();
+  EXPECT_EQ(0, misses);
+  EXPECT_LE(test.GetGlobalDepth(), 6);
+}
+
+// Timing only, run it with --gtest_also_run_disabled_tests
+TEST(ExtendibleHashTest, DISABLED_ScalingBenchmark) {
+  // 90% finds of present keys, 10% inserts of new keys, which keep the
+  // table splitting
+  const int num_keys = 10000;
+  const int num_ops = 640000;
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    ExtendibleHash<int, int> test(BUCKET_SIZE);
+    for (int i = 0; i < num_keys; i++)
+      test.Insert(i, i);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.push_back(std::thread([&test, tid, num_threads]() {
+        int value;
+        int next_key = num_keys + tid;
+        for (int i = 0; i < num_ops / num_threads; i++) {
+          if (i % 10 == 0) {
+            test.Insert(next_key, next_key);
+            next_key += num_threads;
+          } else {
+            test.Find((i * 7919 + tid) % num_keys, value);
+          }
+        }
+      }));
+    }
+    for (auto &thread : threads)
+      thread.join();
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+    std::cout << num_threads << " threads: " << num_ops / seconds
+              << " ops per second" << std::endl;
+  }
+}
+
 TEST(ExtendibleHashTest, ConcurrentInsertTest) {
   const int num_runs = 50;
   const int num_threads = 3;
@@ -0,0 +1,142 @@
+/**
+ * linear_hash_test.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hash/extendible_hash.h"
+#include "hash/linear_hash.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LinearHashTest, SampleTest) {
+  LinearHash<int, std::string> test(2);
+  for (int i = 1; i <= 9; i++)
+    test.Insert(i, std::string(1, 'a' + i - 1));
+  EXPECT_EQ(9U, test.GetSize());
+
+  std::string result;
+  EXPECT_TRUE(test.Find(9, result));
+  EXPECT_EQ("i", result);
+  EXPECT_TRUE(test.Find(1, result));
+  EXPECT_EQ("a", result);
+  EXPECT_FALSE(test.Find(10, result));
+
+  // update
+  test.Insert(1, "z");
+  EXPECT_TRUE(test.Find(1, result));
+  EXPECT_EQ("z", result);
+  EXPECT_EQ(9U, test.GetSize());
+
+  EXPECT_TRUE(test.Remove(8));
+  EXPECT_TRUE(test.Remove(4));
+  EXPECT_TRUE(test.Remove(1));
+  EXPECT_FALSE(test.Remove(20));
+  EXPECT_FALSE(test.Find(4, result));
+  EXPECT_EQ(6U, test.GetSize());
+}
+
+TEST(LinearHashTest, GrowthTest) {
+  // one bucket more at most per insert, keeping the load at the bucket size
+  LinearHash<int, int> test(4);
+  size_t num_buckets = test.GetNumBuckets();
+  for (int i = 0; i < 100000; i++) {
+    test.Insert(i, i);
+    size_t now = test.GetNumBuckets();
+    if (now > num_buckets + 1) {
+      EXPECT_LE(now, num_buckets + 1);
+    }
+    num_buckets = now;
+  }
+  EXPECT_GE(num_buckets * 4, 100000U);
+  EXPECT_LE(num_buckets * 4, 100004U);
+  int value;
+  for (int i = 0; i < 100000; i++) {
+    if (!test.Find(i, value) || value != i) {
+      EXPECT_TRUE(false) << "key " << i;
+      break;
+    }
+  }
+}
+
+TEST(LinearHashTest, ConcurrentTest) {
+  // every thread inserts, finds and removes its own keys while the table
+  // splits under the others
+  LinearHash<int, int> test(4);
+  const int num_threads = 8;
+  const int per_thread = 20000;
+  std::atomic<int> errors(0);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&test, &errors, tid]() {
+      int value;
+      for (int i = tid; i < num_threads * per_thread; i += num_threads)
+        test.Insert(i, i);
+      for (int i = tid; i < num_threads * per_thread; i += num_threads)
+        if (!test.Find(i, value) || value != i)
+          errors++;
+      for (int i = tid; i < num_threads * per_thread; i += 2 * num_threads)
+        if (!test.Remove(i))
+          errors++;
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(0, errors);
+  EXPECT_EQ(num_threads * per_thread / 2, (int)test.GetSize());
+  int value;
+  for (int i = 0; i < num_threads * per_thread; i++) {
+    bool removed = i % (2 * num_threads) < num_threads;
+    if (test.Find(i, value) == removed) {
+      EXPECT_NE(removed, test.Find(i, value)) << "key " << i;
+      break;
+    }
+  }
+}
+
+// latencies of inserting count keys one by one, sorted
+static std::vector<double> InsertLatencies(HashTable<int, int> *table,
+                                           int count) {
+  std::vector<double> latencies;
+  latencies.reserve(count);
+  for (int i = 0; i < count; i++) {
+    auto start = std::chrono::steady_clock::now();
+    table->Insert(i, i);
+    latencies.push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+// Timing only, run it with --gtest_also_run_disabled_tests
+TEST(LinearHashTest, DISABLED_TailLatencyBenchmark) {
+  // steady growth from empty, as a page table or lock table sees it: the
+  // extendible table doubles its directory now and then, the linear table
+  // splits one bucket per insert
+  const int count = 1 << 20;
+  ExtendibleHash<int, int> extendible(BUCKET_SIZE);
+  LinearHash<int, int> linear(BUCKET_SIZE);
+  std::vector<std::pair<std::string, HashTable<int, int> *>> tables = {
+      {"extendible", &extendible}, {"linear", &linear}};
+  for (auto &table : tables) {
+    std::vector<double> latencies = InsertLatencies(table.second, count);
+    std::cout << table.first << " insert latency (us): p50 "
+              << latencies[count / 2] << "  p99 " << latencies[count / 100 * 99]
+              << "  p99.9 " << latencies[count / 1000 * 999] << "  max "
+              << latencies.back() << std::endl;
+  }
+  int value;
+  EXPECT_TRUE(linear.Find(count - 1, value));
+  EXPECT_TRUE(extendible.Find(count - 1, value));
+}
+
+} // namespace cmudb
@@ -3,25 +3,122 @@
  */
 
 #include <algorithm>
+#include <climits>
 #include <cstdio>
 #include <iostream>
 #include <sstream>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
 namespace cmudb {
 
+typedef BPlusTree<GenericKey<8>, RID, GenericComparator<8>> TestTree;
+typedef BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>
+    TestLeafPage;
+typedef BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>
+    TestInternalPage;
+
+/*
+ * Walk the subtree of page_id: every node points back at its parent, its keys
+ * are sorted and within [lower, upper), the bounds the separators of its
+ * ancestors give. Returns the number of keys in the leaves
+ */
+static int64_t CheckSubtree(BufferPoolManager *bpm, page_id_t page_id,
+                            page_id_t parent_id, int64_t lower,
+                            int64_t upper) {
+  Page *page = bpm->FetchPage(page_id);
+  EXPECT_NE(nullptr, page);
+  if (page == nullptr)
+    return 0;
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  EXPECT_EQ(parent_id, node->GetParentPageId()) << "page " << page_id;
+  int64_t count = 0;
+  if (node->IsLeafPage()) {
+    auto leaf = reinterpret_cast<TestLeafPage *>(node);
+    for (int i = 0; i < leaf->GetSize(); ++i) {
+      int64_t key = leaf->KeyAt(i).ToString();
+      EXPECT_LE(lower, key) << "page " << page_id;
+      EXPECT_GT(upper, key) << "page " << page_id;
+      if (i > 0) {
+        EXPECT_LT(leaf->KeyAt(i - 1).ToString(), key) << "page " << page_id;
+      }
+    }
+    count = leaf->GetSize();
+  } else {
+    auto internal = reinterpret_cast<TestInternalPage *>(node);
+    for (int i = 0; i < internal->GetSize(); ++i) {
+      int64_t child_lower = i == 0 ? lower : internal->KeyAt(i).ToString();
+      int64_t child_upper = i + 1 == internal->GetSize()
+                                ? upper
+                                : internal->KeyAt(i + 1).ToString();
+      EXPECT_LE(lower, child_lower) << "page " << page_id;
+      EXPECT_LT(child_lower, child_upper) << "page " << page_id;
+      count += CheckSubtree(bpm, internal->ValueAt(i), page_id, child_lower,
+                            child_upper);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+  return count;
+}
+
+// the checks of CheckSubtree from the root, returns the number of keys
+static int64_t CheckTree(BufferPoolManager *bpm) {
+  auto header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  page_id_t root_id;
+  bool found = header_page->GetRootId("foo_pk", root_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  if (!found || root_id == INVALID_PAGE_ID)
+    return 0;
+  return CheckSubtree(bpm, root_id, INVALID_PAGE_ID, LLONG_MIN, LLONG_MAX);
+}
+
+static void InsertKeys(TestTree &tree, const std::vector<int64_t> &keys,
+                       Transaction *transaction) {
+  GenericKey<8> index_key;
+  RID rid;
+  for (auto key : keys) {
+    rid.Set(0, static_cast<uint32_t>(key));
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+}
+
+// remove keys one by one, checking the whole tree after every removal
+static void RemoveKeys(TestTree &tree, BufferPoolManager *bpm,
+                       const std::vector<int64_t> &keys, int64_t remaining,
+                       Transaction *transaction) {
+  GenericKey<8> index_key;
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+    remaining--;
+    ASSERT_EQ(remaining, CheckTree(bpm)) << "after removing " << key;
+    ASSERT_FALSE(::testing::Test::HasFailure()) << "after removing " << key;
+  }
+}
+
+static void ExpectKeys(TestTree &tree, const std::vector<int64_t> &keys) {
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, tree.GetValue(index_key, rids)) << "key " << key;
+  }
+}
+
 TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -84,7 +181,7 @@ TEST(BPlusTreeTests, InsertTest2) {
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -156,7 +253,7 @@ TEST(BPlusTreeTests, DeleteTest1) {
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -239,7 +336,7 @@ TEST(BPlusTreeTests, DeleteTest2) {
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -320,7 +417,7 @@ TEST(BPlusTreeTests, ScaleTest) {
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(30, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -403,4 +500,207 @@ TEST(BPlusTreeTests, ScaleTest) {
   remove("test.db");
   remove("test.log");
 }
+
+/*
+ * The rightmost leaf underflows and borrows the last entry of its left
+ * sibling, which must become its first entry
+ */
+TEST(BPlusTreeTests, LeafRedistributeFromLeftTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  TestTree tree("foo_pk", bpm, comparator);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+
+  // two leaves of even keys, then the left one filled up with odd keys
+  std::vector<int64_t> keys, odd_keys, remove_keys;
+  for (int64_t key = 2; key <= 60; key += 2)
+    keys.push_back(key);
+  for (int64_t key = 1; key < 20; key += 2)
+    odd_keys.push_back(key);
+  InsertKeys(tree, keys, transaction);
+  InsertKeys(tree, odd_keys, transaction);
+  int64_t count = keys.size() + odd_keys.size();
+  ASSERT_EQ(count, CheckTree(bpm));
+
+  for (int64_t key = 60; key > 40; key -= 2)
+    remove_keys.push_back(key);
+  RemoveKeys(tree, bpm, remove_keys, count, transaction);
+  std::vector<int64_t> left_keys(odd_keys);
+  for (int64_t key = 2; key <= 40; key += 2)
+    left_keys.push_back(key);
+  ExpectKeys(tree, left_keys);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Internal pages merge and borrow from each other: the moved children must
+ * point at their new parent, and the separator of the parent comes down with
+ * them
+ */
+TEST(BPlusTreeTests, InternalRedistributeTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  TestTree tree("foo_pk", bpm, comparator);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+
+  // three levels: leaves of keys 10 apart, then the leaves of the first
+  // internal page split further with the keys in between
+  std::vector<int64_t> keys, fill_keys;
+  for (int64_t key = 10; key <= 10000; key += 10)
+    keys.push_back(key);
+  for (int64_t key = 5; key < 3000; key += 10)
+    fill_keys.push_back(key);
+  InsertKeys(tree, keys, transaction);
+  InsertKeys(tree, fill_keys, transaction);
+  int64_t count = keys.size() + fill_keys.size();
+  ASSERT_EQ(count, CheckTree(bpm));
+
+  // empty the tree from the right, then from the left
+  std::vector<int64_t> remove_keys(keys.rbegin(), keys.rend() - 100);
+  RemoveKeys(tree, bpm, remove_keys, count, transaction);
+  count -= remove_keys.size();
+  ExpectKeys(tree, fill_keys);
+  remove_keys = fill_keys;
+  RemoveKeys(tree, bpm, remove_keys, count, transaction);
+  ExpectKeys(tree, std::vector<int64_t>(keys.begin(), keys.begin() + 100));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * The root is left with a single child, which becomes the root and must not
+ * point at the deleted page anymore: removals from it would go there
+ */
+TEST(BPlusTreeTests, RootCollapseTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  TestTree tree("foo_pk", bpm, comparator);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+
+  std::vector<int64_t> keys, remove_keys;
+  for (int64_t key = 1; key <= 40; ++key)
+    keys.push_back(key);
+  InsertKeys(tree, keys, transaction);
+  ASSERT_EQ(static_cast<int64_t>(keys.size()), CheckTree(bpm));
+
+  // down to a single leaf root, then down to nothing
+  remove_keys.assign(keys.rbegin(), keys.rend());
+  RemoveKeys(tree, bpm, remove_keys, keys.size(), transaction);
+  EXPECT_EQ(true, tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Moves between two internal pages under one parent. The first key of an
+ * internal page is invalid, so the key going along with a first child is the
+ * separator pulled down from the parent, and moved children point at their
+ * new parent
+ */
+TEST(BPlusTreeTests, InternalPageMoveTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  GenericKey<8> key;
+  page_id_t parent_id, left_id, right_id, child_ids[6];
+  auto parent = reinterpret_cast<TestInternalPage *>(
+      bpm->NewPage(parent_id)->GetData());
+  auto left = reinterpret_cast<TestInternalPage *>(
+      bpm->NewPage(left_id)->GetData());
+  auto right = reinterpret_cast<TestInternalPage *>(
+      bpm->NewPage(right_id)->GetData());
+  for (int i = 0; i < 6; ++i) {
+    auto child = reinterpret_cast<TestLeafPage *>(
+        bpm->NewPage(child_ids[i])->GetData());
+    child->Init(child_ids[i], i < 3 ? left_id : right_id);
+    bpm->UnpinPage(child_ids[i], true);
+  }
+  auto parent_of = [&](int i) {
+    page_id_t id = reinterpret_cast<BPlusTreePage *>(
+                       bpm->FetchPage(child_ids[i])->GetData())
+                       ->GetParentPageId();
+    bpm->UnpinPage(child_ids[i], false);
+    return id;
+  };
+  // parent: left | 100 | right, left: c0 | 10 | c1 | 20 | c2,
+  // right: c3 | 110 | c4 | 120 | c5, first keys of the children garbage
+  auto reset = [&]() {
+    parent->Init(parent_id);
+    key.SetFromInteger(100);
+    parent->PopulateNewRoot(left_id, key, right_id);
+    left->Init(left_id, parent_id);
+    key.SetFromInteger(10);
+    left->PopulateNewRoot(child_ids[0], key, child_ids[1]);
+    key.SetFromInteger(20);
+    left->InsertNodeAfter(child_ids[1], key, child_ids[2]);
+    right->Init(right_id, parent_id);
+    key.SetFromInteger(110);
+    right->PopulateNewRoot(child_ids[3], key, child_ids[4]);
+    key.SetFromInteger(120);
+    right->InsertNodeAfter(child_ids[4], key, child_ids[5]);
+    key.SetFromInteger(-1);
+    left->SetKeyAt(0, key);
+    right->SetKeyAt(0, key);
+  };
+
+  // right borrows the last child of left
+  reset();
+  left->MoveLastToFrontOf(right, 1, bpm);
+  ASSERT_EQ(4, right->GetSize());
+  EXPECT_EQ(child_ids[2], right->ValueAt(0));
+  EXPECT_EQ(100, right->KeyAt(1).ToString());
+  EXPECT_EQ(110, right->KeyAt(2).ToString());
+  EXPECT_EQ(right_id, parent_of(2));
+
+  // left borrows the first child of right
+  reset();
+  right->MoveFirstToEndOf(left, bpm);
+  ASSERT_EQ(4, left->GetSize());
+  EXPECT_EQ(child_ids[3], left->ValueAt(3));
+  EXPECT_EQ(100, left->KeyAt(3).ToString());
+  EXPECT_EQ(left_id, parent_of(3));
+
+  // right merges into left
+  reset();
+  right->MoveAllTo(left, 1, bpm);
+  ASSERT_EQ(6, left->GetSize());
+  EXPECT_EQ(100, left->KeyAt(3).ToString());
+  EXPECT_EQ(110, left->KeyAt(4).ToString());
+  for (int i = 3; i < 6; ++i)
+    EXPECT_EQ(left_id, parent_of(i));
+
+  bpm->UnpinPage(parent_id, true);
+  bpm->UnpinPage(left_id, true);
+  bpm->UnpinPage(right_id, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+}
 } // namespace cmudb
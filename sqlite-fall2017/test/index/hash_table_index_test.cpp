@@ -0,0 +1,222 @@
+/**
+ * hash_table_index_test.cpp
+ */
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "index/extendible_hash_table.h"
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(HashTableIndexTest, InsertRemoveTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create and fetch header_page
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  EXPECT_EQ(0U, table.GetGlobalDepth());
+
+  GenericKey<8> index_key;
+  RID rid;
+  const int64_t count = 20000;
+  for (int64_t key = 0; key < count; key++) {
+    rid.Set((int32_t)(key >> 16), (uint32_t)(key & 0xFFFF));
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Insert(index_key, rid));
+  }
+  // the directory grew past one segment
+  EXPECT_GT(1U << table.GetGlobalDepth(), (uint32_t)SEGMENT_SLOTS);
+  // unique keys
+  index_key.SetFromInteger(42);
+  EXPECT_FALSE(table.Insert(index_key, rid));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < count; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    table.GetValue(index_key, rids);
+    ASSERT_EQ(1U, rids.size());
+    EXPECT_EQ((int32_t)(key >> 16), rids[0].GetPageId());
+    EXPECT_EQ((uint32_t)(key & 0xFFFF), rids[0].GetSlotNum());
+  }
+
+  for (int64_t key = 0; key < count; key += 2) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Remove(index_key));
+  }
+  index_key.SetFromInteger(0);
+  EXPECT_FALSE(table.Remove(index_key));
+  for (int64_t key = 0; key < count; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 1, table.GetValue(index_key, rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(HashTableIndexTest, OverflowTest) {
+  // more keys than the buckets of the largest directory hold
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+
+  GenericKey<8> index_key;
+  RID rid;
+  const int64_t count = 200000;
+  for (int64_t key = 0; key < count; key++) {
+    rid.Set((int32_t)key, 0);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Insert(index_key, rid));
+  }
+  EXPECT_EQ((uint32_t)DIRECTORY_MAX_SLOTS, 1U << table.GetGlobalDepth());
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < count; key += 7) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(table.GetValue(index_key, rids));
+    EXPECT_EQ((int32_t)key, rids[0].GetPageId());
+  }
+  index_key.SetFromInteger(count - 1);
+  EXPECT_TRUE(table.Remove(index_key));
+  rids.clear();
+  EXPECT_FALSE(table.GetValue(index_key, rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(HashTableIndexTest, ConcurrentInsertTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+
+  const int num_threads = 4;
+  const int64_t per_thread = 5000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&table, tid]() {
+      GenericKey<8> index_key;
+      RID rid;
+      for (int64_t key = tid; key < num_threads * per_thread;
+           key += num_threads) {
+        rid.Set((int32_t)key, 0);
+        index_key.SetFromInteger(key);
+        table.Insert(index_key, rid);
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_threads * per_thread; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(table.GetValue(index_key, rids)) << "key " << key;
+  }
+  EXPECT_EQ((size_t)(num_threads * per_thread), rids.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(HashTableIndexTest, ConstructIndexTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // a small pool, so lookups go to disk
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  Schema *schema = ParseCreateStatement("a int, b varchar(8)");
+  std::string index_string = "foo_idx a using hash";
+  IndexMetadata *metadata = ParseIndexStatement(index_string, "foo", schema);
+  EXPECT_EQ(IndexType::HASH, metadata->GetIndexType());
+  Index *index = ConstructIndex(metadata, bpm);
+  using IndexType4 = HashTableIndex<GenericKey<4>, RID, GenericComparator<4>>;
+  ASSERT_NE(nullptr, dynamic_cast<IndexType4 *>(index));
+
+  const int count = 5000;
+  for (int i = 0; i < count; i++) {
+    Tuple key({Value(TypeId::INTEGER, i)}, index->GetKeySchema());
+    index->InsertEntry(key, RID(i, i % 7));
+  }
+
+  // reopen from the directory page recorded in the header page
+  page_id_t directory_page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  EXPECT_TRUE(header_page->GetRootId("foo_idx", directory_page_id));
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  delete index;
+  index_string = "foo_idx a using hash";
+  metadata = ParseIndexStatement(index_string, "foo", schema);
+  index = ConstructIndex(metadata, bpm, directory_page_id);
+
+  // a point lookup reads the directory and one bucket at most
+  auto before = bpm->GetMetrics();
+  std::vector<RID> result;
+  for (int i = 0; i < count; i += 10) {
+    Tuple key({Value(TypeId::INTEGER, i)}, index->GetKeySchema());
+    index->ScanKey(key, result);
+  }
+  auto after = bpm->GetMetrics();
+  ASSERT_EQ((size_t)(count / 10), result.size());
+  for (int i = 0; i < count / 10; i++) {
+    EXPECT_EQ(i * 10, result[i].GetPageId());
+    EXPECT_EQ((uint32_t)(i * 10 % 7), result[i].GetSlotNum());
+  }
+  EXPECT_LE(after.misses - before.misses, (uint64_t)(2 * count / 10));
+
+  Tuple key({Value(TypeId::INTEGER, 10)}, index->GetKeySchema());
+  index->DeleteEntry(key);
+  result.clear();
+  index->ScanKey(key, result);
+  EXPECT_TRUE(result.empty());
+
+  // b+ tree stays the default
+  index_string = "bar_idx a";
+  metadata = ParseIndexStatement(index_string, "foo", schema);
+  EXPECT_EQ(IndexType::BPLUS_TREE, metadata->GetIndexType());
+  delete metadata;
+  index_string = "bar_idx a using bitmap";
+  EXPECT_THROW(ParseIndexStatement(index_string, "foo", schema), Exception);
+
+  delete index;
+  delete schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+} // namespace cmudb
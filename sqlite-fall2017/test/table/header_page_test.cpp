@@ -1,7 +1,7 @@
 #include <cstdio>
 #include <cstdlib>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
@@ -12,7 +12,7 @@ namespace cmudb {
 TEST(HeaderPageTest, UnitTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *buffer_pool_manager =
-      new BufferPoolManager(20, disk_manager);
+      new BufferPoolManagerInstance(20, disk_manager);
   page_id_t header_page_id;
   HeaderPage *page =
       static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
@@ -8,7 +8,7 @@
 #include <string>
 #include <vector>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "logging/common.h"
 #include "table/table_heap.h"
 #include "table/tuple.h"
@@ -27,7 +27,7 @@ TEST(TupleTest, TableHeapTest) {
   Transaction *transaction = new Transaction(0);
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *buffer_pool_manager =
-      new BufferPoolManager(50, disk_manager);
+      new BufferPoolManagerInstance(50, disk_manager);
   LockManager *lock_manager = new LockManager(true);
   LogManager *log_manager = new LogManager(disk_manager);
   TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
@@ -4,6 +4,51 @@
 #include "vtable/testing_vtable_util.h"
 
 namespace cmudb {
+/** Query the buffer pool metrics through the vtable_stats table, which is
+ *  registered together with the vtable module
+ */
+TEST(VtableTest, StatsTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  rc = sqlite3_load_extension(db, "libvtable", 0, 0);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM vtable_stats"));
+
+  // creating the header page took a frame from the free list: no fetch yet
+  sqlite3_stmt *stmt;
+  rc = sqlite3_prepare_v2(
+      db, "SELECT name, value FROM vtable_stats WHERE upper_bound_ns IS NULL",
+      -1, &stmt, nullptr);
+  ASSERT_EQ(rc, SQLITE_OK);
+  int counters = 0;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    std::string name(
+        reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+    if (name == "hits" || name == "misses" || name == "evictions") {
+      EXPECT_EQ(0, sqlite3_column_int64(stmt, 1));
+    }
+    counters++;
+  }
+  EXPECT_EQ(7, counters);
+  sqlite3_finalize(stmt);
+
+  // read only
+  EXPECT_FALSE(ExecSQL(db, "DELETE FROM vtable_stats"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
 /** Load the virtual table extension
  *  Ref: https://sqlite.org/c3ref/load_extension.html
  */